@@ -0,0 +1,601 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <string>
+#include <cstring>
+#include <bit>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <format>
+
+#include "MirrorClass.h"
+#include "MirrorProperty.h"
+#include "MirrorMethod.h"
+
+#define BINARY_CLASS(name, ...) MIRROR_CLASS(name, Mirror::Class, BinaryProperty, Mirror::Method,, __VA_ARGS__)
+#define BINARY_STRUCT(name, ...) MIRROR_STRUCT(name, Mirror::Class, BinaryProperty, Mirror::Method,, __VA_ARGS__)
+
+// Growable output buffer with varint encoding of integers
+class BinaryWriter
+{
+	std::vector<char> data;
+
+public:
+	BinaryWriter() = default;
+
+	// Append to existing bytes
+	explicit BinaryWriter(std::vector<char>&& data) : data(std::move(data)) {}
+
+	void WriteBytes(const void* bytes, size_t size)
+	{
+		data.insert(data.end(), (const char*)bytes, (const char*)bytes + size);
+	}
+
+	void WriteVarint(uint64_t value)
+	{
+		char bytes[10];
+		size_t size = 0;
+		for (; value >= 0x80; value >>= 7)
+			bytes[size++] = char(value | 0x80);
+		bytes[size++] = char(value);
+		WriteBytes(bytes, size);
+	}
+
+	// Zigzag encoding keeps small negative values short
+	void WriteSigned(int64_t value) { WriteVarint(uint64_t(value) << 1 ^ uint64_t(value >> 63)); }
+
+	template<typename Type>
+	void WriteRaw(const Type& value) { WriteBytes(&value, sizeof(Type)); }
+
+	std::span<const char> Data() const { return data; }
+	std::vector<char> Take() { return std::move(data); }
+};
+
+// Bounds checked input buffer. Throws on truncated or corrupt data.
+class BinaryReader
+{
+	const char* pos;
+	const char* end;
+
+public:
+	explicit BinaryReader(std::span<const char> data) : pos(data.data()), end(data.data() + data.size()) {}
+
+	void ReadBytes(void* bytes, size_t size)
+	{
+		Require(size);
+		memcpy(bytes, pos, size);
+		pos += size;
+	}
+
+	uint64_t ReadVarint()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			Require(1);
+			uint8_t byte = uint8_t(*pos++);
+			value |= uint64_t(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) return value;
+		}
+		throw std::logic_error("Binary archive has an invalid varint");
+	}
+
+	int64_t ReadSigned()
+	{
+		uint64_t value = ReadVarint();
+		return int64_t(value >> 1) ^ -int64_t(value & 1);
+	}
+
+	template<typename Type>
+	Type ReadRaw()
+	{
+		Type value;
+		ReadBytes(&value, sizeof(Type));
+		return value;
+	}
+
+	// Take the next size bytes without copying
+	std::span<const char> ReadSpan(uint64_t size)
+	{
+		if (size > Remaining())
+			throw std::logic_error("Binary archive is truncated");
+		std::span<const char> bytes(pos, size_t(size));
+		pos += size;
+		return bytes;
+	}
+
+	size_t Remaining() const { return size_t(end - pos); }
+
+private:
+	void Require(size_t size)
+	{
+		if (Remaining() < size)
+			throw std::logic_error("Binary archive is truncated");
+	}
+};
+
+template<typename> struct BinaryValue;
+
+// Element type that can be read into, map elements have a const key
+template<typename Type>
+struct BinaryMutable { using Value = Type; };
+
+template<typename First, typename Second>
+struct BinaryMutable<std::pair<const First, Second>> { using Value = std::pair<First, Second>; };
+
+template<typename Type>
+concept BinarySerializable = std::default_initializable<Type> && requires(BinaryWriter& writer, BinaryReader& reader, Type& value)
+{
+	BinaryValue<Type>::Write(writer, value);
+	BinaryValue<Type>::Read(reader, value);
+};
+
+// Binary serialization of a property, also encodes its values in deltas
+class BinaryProperty : public virtual Mirror::Property, public Mirror::DeltaCodec
+{
+	void (*write)(void*, const Mirror::Property*, BinaryWriter&) = nullptr;
+	void (*read)(void*, const Mirror::Property*, BinaryReader&) = nullptr;
+
+public:
+	bool raw = false; // arithmetic or enum, any bytes are a valid value; bool is excluded
+
+	template<typename Type>
+	static void Writer(void* obj, const Mirror::Property* property, BinaryWriter& writer)
+	{
+		BinaryValue<Type>::Write(writer, property->GetValue<Type>(obj));
+	}
+
+	template<typename Type>
+	static void Reader(void* obj, const Mirror::Property* property, BinaryReader& reader)
+	{
+		if (void* storage = property->GetStorage(obj))
+		{
+			BinaryValue<Type>::Read(reader, *(Type*)storage);
+			return;
+		}
+
+		Type value{};
+		BinaryValue<Type>::Read(reader, value);
+		property->SetValue(obj, std::move(value));
+	}
+
+public:
+	template<typename Meta>
+	BinaryProperty(Meta* meta) : Property(meta)
+	{
+		using Type = typename Meta::Type;
+		raw = (std::is_arithmetic_v<Type> && !std::is_same_v<Type, bool>) || std::is_enum_v<Type>;
+
+		if constexpr (BinarySerializable<typename Meta::Type> && std::is_move_assignable_v<typename Meta::Type>)
+		{
+			write = &BinaryProperty::Writer<typename Meta::Type>;
+			read = &BinaryProperty::Reader<typename Meta::Type>;
+		}
+	}
+
+	void Write(void* obj, BinaryWriter& writer) const { write(obj, this, writer); }
+	void Read(void* obj, BinaryReader& reader) const { read(obj, this, reader); }
+
+	bool CanSerialize() const { return write != nullptr; }
+
+	bool CanEncodeValue() const override { return CanSerialize(); }
+
+	void EncodeValue(void* obj, std::vector<char>& data) const override
+	{
+		BinaryWriter writer(std::move(data));
+		Write(obj, writer);
+		data = writer.Take();
+	}
+
+	void DecodeValue(void* obj, std::span<const char> bytes) const override
+	{
+		BinaryReader reader(bytes);
+		Read(obj, reader);
+		if (reader.Remaining())
+			throw std::logic_error(std::format("Delta value of '{}' has a wrong size", name));
+	}
+};
+
+// Serialization layout of a class: memcpy runs of adjacent plain arithmetic and enum fields followed by the other properties.
+// Properties that can't be serialized are skipped.
+class BinaryLayout
+{
+	struct Run
+	{
+		ptrdiff_t offset;
+		size_t size;
+		std::vector<const BinaryProperty*> members; // in offset order
+	};
+
+	std::vector<Run> runs;
+	std::vector<const BinaryProperty*> fields;
+	std::vector<uint64_t> tags; // of run members and fields in the order of their values
+	std::unordered_map<uint64_t, const BinaryProperty*> tagged; // properties by tag, to read archives of other schemas
+
+public:
+	uint64_t schema;
+
+	explicit BinaryLayout(const Mirror::Class* cls) : schema(Schema(cls))
+	{
+		std::vector<const BinaryProperty*> packed;
+		for (const Mirror::Property* property : cls->Properties())
+		{
+			const BinaryProperty* binary = dynamic_cast<const BinaryProperty*>(property);
+			if (!binary) continue;
+
+			if (binary->plain && binary->raw && binary->setter)
+				packed.push_back(binary);
+			else if (binary->CanSerialize())
+				fields.push_back(binary);
+		}
+
+		std::ranges::sort(packed, {}, [](const BinaryProperty* p){ return p->offset; });
+		for (size_t i = 0, next; i < packed.size(); i = next)
+		{
+			size_t size = packed[i]->size;
+			for (next = i + 1; next < packed.size() && packed[i]->offset + ptrdiff_t(size) == packed[next]->offset; next++)
+				size += packed[next]->size;
+
+			// single fields are packed as varints
+			if (next - i > 1)
+				runs.push_back({packed[i]->offset, size, {packed.begin() + i, packed.begin() + next}});
+			else if (packed[i]->CanSerialize())
+				fields.push_back(packed[i]);
+		}
+
+		std::vector<const BinaryProperty*> ordered;
+		for (const Run& run : runs)
+			ordered.insert(ordered.end(), run.members.begin(), run.members.end());
+		ordered.insert(ordered.end(), fields.begin(), fields.end());
+
+		for (const BinaryProperty* property : ordered)
+		{
+			tags.push_back(Tag(property));
+			tagged.emplace(tags.back(), property);
+		}
+	}
+
+	bool Empty() const { return runs.empty() && fields.empty(); }
+
+	void Write(BinaryWriter& writer, void* obj) const
+	{
+		for (const Run& run : runs)
+			writer.WriteBytes((char*)obj + run.offset, run.size);
+
+		for (const BinaryProperty* property : fields)
+			property->Write(obj, writer);
+	}
+
+	void Read(BinaryReader& reader, void* obj) const
+	{
+		for (const Run& run : runs)
+			reader.ReadBytes((char*)obj + run.offset, run.size);
+
+		for (const BinaryProperty* property : fields)
+			property->Read(obj, reader);
+	}
+
+	// Write the size-prefixed values followed by a size-prefixed directory: varint count, then the tag and varint size of each value.
+	// The lowest bit of the size is set for raw bytes of a run member and clear for values encoded by the property.
+	void WriteTagged(BinaryWriter& writer, void* obj) const
+	{
+		BinaryWriter body;
+		std::vector<uint64_t> sizes;
+		sizes.reserve(tags.size());
+
+		for (const Run& run : runs)
+		{
+			body.WriteBytes((char*)obj + run.offset, run.size);
+			for (const BinaryProperty* property : run.members)
+				sizes.push_back(uint64_t(property->size) << 1 | 1);
+		}
+
+		for (const BinaryProperty* property : fields)
+		{
+			size_t start = body.Data().size();
+			property->Write(obj, body);
+			sizes.push_back(uint64_t(body.Data().size() - start) << 1);
+		}
+
+		BinaryWriter directory;
+		directory.WriteVarint(sizes.size());
+		for (size_t i = 0; i < sizes.size(); i++)
+		{
+			directory.WriteRaw(tags[i]);
+			directory.WriteVarint(sizes[i]);
+		}
+
+		for (const BinaryWriter* part : {&body, &directory})
+		{
+			writer.WriteVarint(part->Data().size());
+			writer.WriteBytes(part->Data().data(), part->Data().size());
+		}
+	}
+
+	// Read data written by WriteTagged for the same schema, the directory is skipped
+	void ReadTagged(BinaryReader& reader, void* obj) const
+	{
+		BinaryReader body(reader.ReadSpan(reader.ReadVarint()));
+		reader.ReadSpan(reader.ReadVarint());
+		Read(body, obj);
+	}
+
+	// Read data written by WriteTagged for another schema of the class, e.g. before a field was added or reordered.
+	// Values are matched to properties by tag, values of unknown properties are skipped, properties missing in the data keep their values.
+	// The tag includes the schema of a nested class, so a property whose nested class has changed counts as unknown.
+	void ReadByTags(BinaryReader& reader, void* obj) const
+	{
+		BinaryReader body(reader.ReadSpan(reader.ReadVarint()));
+		BinaryReader directory(reader.ReadSpan(reader.ReadVarint()));
+		uint64_t count = directory.ReadVarint();
+		if (count > directory.Remaining() / (sizeof(uint64_t) + 1))
+			throw std::logic_error("Binary archive is truncated");
+
+		for (uint64_t i = 0; i < count; i++)
+		{
+			uint64_t tag = directory.ReadRaw<uint64_t>();
+			uint64_t size = directory.ReadVarint();
+			std::span<const char> value = body.ReadSpan(size >> 1);
+
+			auto found = tagged.find(tag);
+			if (found == tagged.end()) continue;
+			const BinaryProperty* property = found->second;
+
+			if (!(size & 1))
+			{
+				BinaryReader field(value);
+				property->Read(obj, field);
+				if (field.Remaining())
+					throw std::logic_error(std::format("Binary archive value of '{}' has a wrong size", property->name));
+			}
+			else if (property->plain && property->raw && property->setter && value.size() == property->size)
+				memcpy((char*)obj + property->offset, value.data(), value.size());
+		}
+	}
+
+	// Get cached layout of a class. Layouts are built on first use, after all classes are constructed.
+	static const BinaryLayout& Get(const Mirror::Class* cls)
+	{
+		static std::mutex guard;
+		static std::unordered_map<const Mirror::Class*, std::unique_ptr<BinaryLayout>> layouts;
+
+		std::lock_guard lock(guard);
+		auto& layout = layouts[cls];
+		if (!layout) layout = std::make_unique<BinaryLayout>(cls);
+		return *layout;
+	}
+
+	// Fingerprint of property names, types and memory layout including nested classes
+	static uint64_t Schema(const Mirror::Class* cls, int depth = 0)
+	{
+		size_t hash = Mirror::HashBytes(cls->Name().data(), cls->Name().size(), std::endian::native == std::endian::little);
+		for (const Mirror::Property* property : cls->Properties())
+		{
+			std::string_view type = property->type->name();
+			hash = Mirror::HashBytes(property->name.data(), property->name.size(), hash);
+			hash = Mirror::HashBytes(type.data(), type.size(), hash);
+			hash = Mirror::HashCombine(hash, property->size);
+			hash = Mirror::HashCombine(hash, property->plain ? size_t(property->offset) : ~size_t(0));
+
+			const Mirror::Class* nested = Nested(property);
+			if (nested && depth < 8)
+				hash = Mirror::HashCombine(hash, Schema(nested, depth + 1));
+		}
+		return hash;
+	}
+
+	// Identity of a property across schemas of its class: name, type and the schema of its nested class
+	static uint64_t Tag(const Mirror::Property* property)
+	{
+		std::string_view type = property->type->name();
+		size_t hash = Mirror::HashBytes(property->name.data(), property->name.size(), std::endian::native == std::endian::little);
+		hash = Mirror::HashBytes(type.data(), type.size(), hash);
+		if (const Mirror::Class* nested = Nested(property))
+			hash = Mirror::HashCombine(hash, Schema(nested));
+		return hash;
+	}
+
+private:
+	static const Mirror::Class* Nested(const Mirror::Property* property)
+	{
+		if (property->ref_class) return property->ref_class;
+		if (property->container && property->container->value_class) return property->container->value_class();
+		return nullptr;
+	}
+};
+
+struct BinaryArchive
+{
+	static constexpr uint32_t magic = 0x3242524d; // "MRB2"
+
+	// Serialize an object with a header holding the class schema fingerprint, values are followed by a directory of property tags
+	template<Mirror::Mirrored Type>
+	static std::vector<char> Save(const Type& obj)
+	{
+		const BinaryLayout& layout = BinaryLayout::Get(obj.GetClass());
+
+		BinaryWriter writer;
+		writer.WriteRaw(magic);
+		writer.WriteRaw(layout.schema);
+		layout.WriteTagged(writer, obj.GetThis());
+		return writer.Take();
+	}
+
+	// Deserialize an object. Data of the same schema is read by the layout, data of another schema property by property.
+	template<Mirror::Mirrored Type>
+	static void Load(Type& obj, std::span<const char> data)
+	{
+		const BinaryLayout& layout = BinaryLayout::Get(obj.GetClass());
+
+		BinaryReader reader(data);
+		if (reader.ReadRaw<uint32_t>() != magic)
+			throw std::logic_error("Data is not a binary archive");
+
+		if (reader.ReadRaw<uint64_t>() == layout.schema)
+			layout.ReadTagged(reader, obj.GetThis());
+		else
+			layout.ReadByTags(reader, obj.GetThis());
+	}
+};
+
+template<>
+struct BinaryValue<bool>
+{
+	static void Write(BinaryWriter& writer, bool value) { writer.WriteRaw(uint8_t(value)); }
+	static void Read(BinaryReader& reader, bool& value) { value = reader.ReadRaw<uint8_t>() != 0; }
+};
+
+template<typename Type> requires (std::is_integral_v<Type> && !std::is_same_v<bool, Type>)
+struct BinaryValue<Type>
+{
+	static void Write(BinaryWriter& writer, Type value)
+	{
+		if constexpr (std::is_signed_v<Type>) writer.WriteSigned(value);
+		else writer.WriteVarint(value);
+	}
+
+	static void Read(BinaryReader& reader, Type& value)
+	{
+		if constexpr (std::is_signed_v<Type>) value = Type(reader.ReadSigned());
+		else value = Type(reader.ReadVarint());
+	}
+};
+
+template<typename Type> requires std::is_floating_point_v<Type>
+struct BinaryValue<Type>
+{
+	static void Write(BinaryWriter& writer, Type value) { writer.WriteRaw(value); }
+	static void Read(BinaryReader& reader, Type& value) { value = reader.ReadRaw<Type>(); }
+};
+
+template<typename Type> requires std::is_enum_v<Type>
+struct BinaryValue<Type>
+{
+	using Underlying = std::underlying_type_t<Type>;
+
+	static void Write(BinaryWriter& writer, Type value) { BinaryValue<Underlying>::Write(writer, Underlying(value)); }
+
+	static void Read(BinaryReader& reader, Type& value)
+	{
+		Underlying underlying;
+		BinaryValue<Underlying>::Read(reader, underlying);
+		value = Type(underlying);
+	}
+};
+
+template<>
+struct BinaryValue<std::string>
+{
+	static void Write(BinaryWriter& writer, const std::string& str)
+	{
+		writer.WriteVarint(str.size());
+		writer.WriteBytes(str.data(), str.size());
+	}
+
+	static void Read(BinaryReader& reader, std::string& str)
+	{
+		uint64_t size = reader.ReadVarint();
+		if (size > reader.Remaining())
+			throw std::logic_error("Binary archive is truncated");
+		str.resize(size_t(size));
+		reader.ReadBytes(str.data(), str.size());
+	}
+};
+
+template<typename First, typename Second>
+struct BinaryValue<std::pair<First, Second>>
+{
+	static void Write(BinaryWriter& writer, const std::pair<First, Second>& value)
+	{
+		BinaryValue<std::remove_const_t<First>>::Write(writer, value.first);
+		BinaryValue<Second>::Write(writer, value.second);
+	}
+
+	static void Read(BinaryReader& reader, std::pair<First, Second>& value) requires (!std::is_const_v<First>)
+	{
+		BinaryValue<First>::Read(reader, value.first);
+		BinaryValue<Second>::Read(reader, value.second);
+	}
+};
+
+template<Mirror::Mirrored Type>
+struct BinaryValue<Type>
+{
+	static const BinaryLayout& Layout()
+	{
+		static const BinaryLayout& layout = BinaryLayout::Get(Type::Meta::GetClass());
+		return layout;
+	}
+
+	// Objects without serializable properties take a byte, so container sizes can always be checked against the data left
+	static void Write(BinaryWriter& writer, const Type& obj)
+	{
+		if (Layout().Empty()) writer.WriteRaw(uint8_t(0));
+		else Layout().Write(writer, obj.GetThis());
+	}
+
+	static void Read(BinaryReader& reader, Type& obj)
+	{
+		if (Layout().Empty()) reader.ReadRaw<uint8_t>();
+		else Layout().Read(reader, obj.GetThis());
+	}
+};
+
+// Length-prefixed containers. Contiguous ranges of floats and bytes are copied in bulk.
+template<typename Type> requires (Mirror::StlContainer<Type> && !Mirror::StlString<Type> && !Mirror::Mirrored<Type>
+	&& std::is_reference_v<std::ranges::range_reference_t<Type>> && BinarySerializable<typename BinaryMutable<typename Type::value_type>::Value>)
+struct BinaryValue<Type>
+{
+	using Element = typename Type::value_type;
+	using Mutable = typename BinaryMutable<Element>::Value;
+
+	static constexpr bool bulk = std::ranges::contiguous_range<Type> && (std::is_floating_point_v<Element> || (std::is_integral_v<Element> && sizeof(Element) == 1));
+
+	static void Write(BinaryWriter& writer, const Type& range)
+	{
+		writer.WriteVarint(uint64_t(std::ranges::distance(range)));
+		if constexpr (bulk)
+			writer.WriteBytes(std::ranges::data(range), std::ranges::size(range) * sizeof(Element));
+		else
+			for (auto& value : range)
+				BinaryValue<Element>::Write(writer, value);
+	}
+
+	static void Read(BinaryReader& reader, Type& range)
+	{
+		uint64_t size = reader.ReadVarint();
+		if (size > reader.Remaining())
+			throw std::logic_error("Binary archive is truncated");
+
+		if constexpr (requires { range.resize(size_t(size)); })
+		{
+			range.resize(size_t(size));
+			if constexpr (bulk)
+				reader.ReadBytes(std::ranges::data(range), range.size() * sizeof(Element));
+			else
+				for (auto& value : range)
+					BinaryValue<Element>::Read(reader, value);
+		}
+		else if constexpr (requires (Mutable&& value) { range.insert(std::move(value)); })
+		{
+			range.clear();
+			for (uint64_t i = 0; i < size; i++)
+			{
+				Mutable value{};
+				BinaryValue<Mutable>::Read(reader, value);
+				range.insert(std::move(value));
+			}
+		}
+		else
+		{
+			if (size != uint64_t(std::ranges::distance(range)))
+				throw std::logic_error("Binary archive has a wrong fixed container size");
+			for (auto& value : range)
+				BinaryValue<Element>::Read(reader, value);
+		}
+	}
+};
\ No newline at end of file
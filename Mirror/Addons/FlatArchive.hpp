@@ -0,0 +1,574 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <bit>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+#include <stdexcept>
+#include <format>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "MirrorClass.h"
+#include "MirrorProperty.h"
+#include "MirrorMethod.h"
+
+#define FLAT_CLASS(name, ...) MIRROR_CLASS(name, Mirror::Class, FlatProperty, Mirror::Method,, __VA_ARGS__)
+#define FLAT_STRUCT(name, ...) MIRROR_STRUCT(name, Mirror::Class, FlatProperty, Mirror::Method,, __VA_ARGS__)
+
+// How a value is stored in a flat archive. Scalars and records are inline, strings and arrays are references to out of line data.
+enum class FlatKind : uint8_t { None, Scalar, String, Record, Array };
+
+// Position of out of line data from the archive start and its number of elements
+struct FlatRef
+{
+	uint64_t offset = 0;
+	uint64_t count = 0;
+};
+
+// Flat archive image under construction. Data is addressed by position since the buffer grows.
+class FlatWriter
+{
+	std::vector<char> data;
+
+public:
+	// Reserve zeroed space aligned to alignment and return its position
+	size_t Allocate(size_t size, size_t alignment)
+	{
+		size_t position = (data.size() + alignment - 1) & ~(alignment - 1);
+		data.resize(position + size);
+		return position;
+	}
+
+	void WriteBytes(size_t position, const void* bytes, size_t size) { memcpy(data.data() + position, bytes, size); }
+
+	template<typename Type>
+	void WriteRaw(size_t position, const Type& value) { WriteBytes(position, &value, sizeof(Type)); }
+
+	// Strings are null terminated so views can pass them to c apis
+	FlatRef WriteString(std::string_view str)
+	{
+		size_t position = Allocate(str.size() + 1, 1);
+		WriteBytes(position, str.data(), str.size());
+		return {position, str.size()};
+	}
+
+	std::vector<char> Take() { return std::move(data); }
+};
+
+class FlatLayout;
+
+template<typename Type>
+struct FlatValue
+{
+	static constexpr FlatKind kind = FlatKind::None;
+};
+
+class FlatProperty : public virtual Mirror::Property
+{
+	void (*write)(const void*, FlatWriter&, size_t) = nullptr;
+
+public:
+	FlatKind flat_kind = FlatKind::None;
+	FlatKind element_kind = FlatKind::None; // kind of array elements
+	const std::type_info* element_type = nullptr;
+	size_t element_size = 0; // size of scalar and string elements, records take the size of their layout
+	size_t element_alignment = 0;
+
+	template<typename Meta>
+	FlatProperty(Meta* meta) : Property(meta)
+	{
+		using Type = typename Meta::Type;
+		if constexpr (FlatValue<Type>::kind != FlatKind::None)
+		{
+			flat_kind = FlatValue<Type>::kind;
+			write = [](const void* value, FlatWriter& writer, size_t position){ FlatValue<Type>::Write(writer, position, *(const Type*)value); };
+
+			if constexpr (FlatValue<Type>::kind == FlatKind::Array)
+			{
+				using Element = typename Type::value_type;
+				element_kind = FlatValue<Element>::kind;
+				element_type = &typeid(Element);
+				if constexpr (FlatValue<Element>::kind != FlatKind::Record)
+				{
+					element_size = FlatValue<Element>::Size();
+					element_alignment = FlatValue<Element>::Alignment();
+				}
+			}
+		}
+	}
+
+	// Write the value returned by the getter at position
+	void Write(const void* value, FlatWriter& writer, size_t position) const { write(value, writer, position); }
+
+	bool CanStore() const { return flat_kind != FlatKind::None && getter; }
+};
+
+// Placement of class properties within a flat record. Properties that can't be stored have no slot kind.
+class FlatLayout
+{
+public:
+	struct Slot
+	{
+		const FlatProperty* property = nullptr;
+		FlatKind kind = FlatKind::None;
+		size_t offset = 0;
+		size_t size = 0;
+		const FlatLayout* nested = nullptr; // layout of a record or of array elements
+	};
+
+	const Mirror::Class* cls;
+	std::vector<Slot> slots; // in class property order
+	size_t size = 0;
+	size_t alignment = 1;
+	uint64_t schema;
+
+	explicit FlatLayout(const Mirror::Class* cls) : cls(cls), schema(Schema(cls)) {}
+
+	void Write(FlatWriter& writer, size_t position, void* obj) const
+	{
+		for (const Slot& slot : slots)
+			if (slot.kind != FlatKind::None)
+				slot.property->Write(slot.property->getter(slot.property->GetScope(obj)), writer, position + slot.offset);
+	}
+
+	const Slot& GetSlot(std::string_view name) const
+	{
+		const Mirror::Property* property = cls->GetProperty(name);
+		if (!property || slots[property->index].kind == FlatKind::None)
+			throw std::logic_error(std::format("Class '{}' has no flat property '{}'", cls->Name(), name));
+		return slots[property->index];
+	}
+
+	// Get cached layout of a class. Layouts are built on first use, after all classes are constructed.
+	static const FlatLayout& Get(const Mirror::Class* cls)
+	{
+		static std::recursive_mutex guard;
+		static std::unordered_map<const Mirror::Class*, std::unique_ptr<FlatLayout>> layouts;
+
+		std::lock_guard lock(guard);
+		auto& layout = layouts[cls];
+		if (!layout)
+		{
+			// registered before it's built, so arrays of the class within the class resolve to it
+			FlatLayout* created = (layout = std::make_unique<FlatLayout>(cls)).get();
+			created->Place();
+			created->Resolve();
+		}
+		return *layouts[cls];
+	}
+
+	// Fingerprint of stored property names, types and kinds including nested classes
+	static uint64_t Schema(const Mirror::Class* cls, int depth = 0)
+	{
+		size_t hash = Mirror::HashBytes(cls->Name().data(), cls->Name().size(), std::endian::native == std::endian::little);
+		for (const Mirror::Property* property : cls->Properties())
+		{
+			const FlatProperty* flat = dynamic_cast<const FlatProperty*>(property);
+			if (!flat || !flat->CanStore()) continue;
+
+			std::string_view type = property->type->name();
+			hash = Mirror::HashBytes(property->name.data(), property->name.size(), hash);
+			hash = Mirror::HashBytes(type.data(), type.size(), hash);
+			hash = Mirror::HashCombine(hash, property->size);
+			hash = Mirror::HashCombine(hash, size_t(flat->flat_kind) << 8 | size_t(flat->element_kind));
+
+			const Mirror::Class* nested = property->ref_class;
+			if (!nested && property->container && property->container->value_class)
+				nested = property->container->value_class();
+
+			if (nested && depth < 8)
+				hash = Mirror::HashCombine(hash, Schema(nested, depth + 1));
+		}
+		return hash;
+	}
+
+private:
+	// Assign slot offsets. Inline records can't be recursive, so their layouts are always complete here.
+	void Place()
+	{
+		for (const Mirror::Property* property : cls->Properties())
+		{
+			Slot& slot = slots.emplace_back();
+			slot.property = dynamic_cast<const FlatProperty*>(property);
+			if (!slot.property || !slot.property->CanStore()) continue;
+
+			size_t slot_alignment;
+			slot.kind = slot.property->flat_kind;
+			switch (slot.kind)
+			{
+			case FlatKind::Scalar:
+				slot.size = property->size;
+				slot_alignment = property->alignment;
+				break;
+			case FlatKind::Record:
+				slot.nested = &Get(property->ref_class);
+				slot.size = slot.nested->size;
+				slot_alignment = slot.nested->alignment;
+				break;
+			default:
+				slot.size = sizeof(FlatRef);
+				slot_alignment = alignof(FlatRef);
+			}
+
+			slot.offset = (size + slot_alignment - 1) & ~(slot_alignment - 1);
+			size = slot.offset + slot.size;
+			alignment = std::max(alignment, slot_alignment);
+		}
+		size = (size + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Array elements may refer back to classes whose layouts are still being built
+	void Resolve()
+	{
+		for (Slot& slot : slots)
+			if (slot.kind == FlatKind::Array && slot.property->element_kind == FlatKind::Record)
+				slot.nested = &Get(slot.property->container->value_class());
+	}
+};
+
+class FlatArray;
+
+// Read-only view of a record within a flat archive. Out of line data is bounds checked on access.
+class FlatView
+{
+	std::span<const char> archive;
+	const char* record = nullptr;
+	const FlatLayout* layout = nullptr;
+
+public:
+	FlatView() = default;
+	FlatView(std::span<const char> archive, const char* record, const FlatLayout* layout) : archive(archive), record(record), layout(layout) {}
+
+	const Mirror::Class* GetClass() const { return layout->cls; }
+	const FlatLayout& GetLayout() const { return *layout; }
+
+	// Copy of a scalar value, the type must match the property type
+	template<typename Type>
+	Type Get(const FlatLayout::Slot& slot) const
+	{
+		if (slot.kind != FlatKind::Scalar || *slot.property->type != typeid(Type))
+			throw std::logic_error(std::format("Flat property '{}' is not of type '{}'", slot.property->name, typeid(Type).name()));
+
+		Type value;
+		memcpy(&value, record + slot.offset, sizeof(Type));
+		return value;
+	}
+
+	std::string_view GetString(const FlatLayout::Slot& slot) const
+	{
+		Require(slot, FlatKind::String);
+		return String(Ref(record + slot.offset), archive);
+	}
+
+	FlatView GetObject(const FlatLayout::Slot& slot) const
+	{
+		Require(slot, FlatKind::Record);
+		return FlatView(archive, record + slot.offset, slot.nested);
+	}
+
+	FlatArray GetArray(const FlatLayout::Slot& slot) const;
+
+	template<typename Type>
+	Type Get(std::string_view name) const { return Get<Type>(layout->GetSlot(name)); }
+
+	std::string_view GetString(std::string_view name) const { return GetString(layout->GetSlot(name)); }
+	FlatView GetObject(std::string_view name) const { return GetObject(layout->GetSlot(name)); }
+	FlatArray GetArray(std::string_view name) const;
+
+	static FlatRef Ref(const char* ptr)
+	{
+		FlatRef ref;
+		memcpy(&ref, ptr, sizeof(FlatRef));
+		return ref;
+	}
+
+	// Pointer to count elements of size bytes, throws if they are out of the archive
+	static const char* Resolve(const FlatRef& ref, size_t size, std::span<const char> archive)
+	{
+		if (ref.offset > archive.size() || (size && ref.count > (archive.size() - ref.offset) / size))
+			throw std::logic_error("Flat archive reference is out of bounds");
+		return archive.data() + ref.offset;
+	}
+
+	// Strings are followed by a null byte, the check avoids computing count + 1
+	static std::string_view String(const FlatRef& ref, std::span<const char> archive)
+	{
+		if (ref.offset > archive.size() || ref.count >= archive.size() - ref.offset)
+			throw std::logic_error("Flat archive reference is out of bounds");
+		return std::string_view(archive.data() + ref.offset, size_t(ref.count));
+	}
+
+private:
+	void Require(const FlatLayout::Slot& slot, FlatKind kind) const
+	{
+		if (slot.kind != kind)
+			throw std::logic_error(std::format("Flat property '{}' has a different kind", slot.property->name));
+	}
+};
+
+// Read-only view of array elements within a flat archive
+class FlatArray
+{
+	std::span<const char> archive;
+	const char* data = nullptr;
+	size_t count = 0;
+	const FlatLayout::Slot* slot = nullptr;
+	size_t stride = 0;
+
+public:
+	FlatArray() = default;
+	FlatArray(std::span<const char> archive, const FlatLayout::Slot& slot, const FlatRef& ref) : archive(archive), slot(&slot)
+	{
+		const FlatProperty* property = slot.property;
+		stride = property->element_kind == FlatKind::Record ? slot.nested->size : property->element_size;
+		data = FlatView::Resolve(ref, stride, archive);
+		count = size_t(ref.count);
+	}
+
+	size_t Size() const { return count; }
+	bool Empty() const { return count == 0; }
+
+	// Scalar elements in place, the type must match the element type
+	template<typename Type>
+	std::span<const Type> Values() const
+	{
+		if (slot->property->element_kind != FlatKind::Scalar || *slot->property->element_type != typeid(Type))
+			throw std::logic_error(std::format("Flat array '{}' is not of type '{}'", slot->property->name, typeid(Type).name()));
+		if (count && uintptr_t(data) % alignof(Type))
+			throw std::logic_error("Flat archive is not aligned");
+		return std::span((const Type*)data, count);
+	}
+
+	std::string_view String(size_t index) const
+	{
+		Require(index, FlatKind::String);
+		return FlatView::String(FlatView::Ref(data + index * stride), archive);
+	}
+
+	FlatView Object(size_t index) const
+	{
+		Require(index, FlatKind::Record);
+		return FlatView(archive, data + index * stride, slot->nested);
+	}
+
+private:
+	void Require(size_t index, FlatKind kind) const
+	{
+		if (slot->property->element_kind != kind)
+			throw std::logic_error(std::format("Flat array '{}' has a different element kind", slot->property->name));
+		if (index >= count)
+			throw std::logic_error(std::format("Flat array '{}' index {} is out of range", slot->property->name, index));
+	}
+};
+
+inline FlatArray FlatView::GetArray(const FlatLayout::Slot& slot) const
+{
+	Require(slot, FlatKind::Array);
+	return FlatArray(archive, slot, Ref(record + slot.offset));
+}
+
+inline FlatArray FlatView::GetArray(std::string_view name) const { return GetArray(layout->GetSlot(name)); }
+
+struct FlatArchive
+{
+	static constexpr uint32_t magic = 0x3146524d; // "MRF1"
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t alignment; // of the root record
+		uint64_t schema;
+		uint64_t root; // position of the root record
+		uint64_t size; // of the whole archive
+	};
+
+	// Lay out an object with everything it references in one buffer
+	template<Mirror::Mirrored Type>
+	static std::vector<char> Save(const Type& obj)
+	{
+		const FlatLayout& layout = FlatLayout::Get(obj.GetClass());
+
+		FlatWriter writer;
+		size_t header = writer.Allocate(sizeof(Header), alignof(Header));
+		size_t root = writer.Allocate(layout.size, layout.alignment);
+		layout.Write(writer, root, obj.GetThis());
+
+		std::vector<char> data = writer.Take();
+		Header info{magic, uint32_t(layout.alignment), layout.schema, root, data.size()};
+		memcpy(data.data() + header, &info, sizeof(Header));
+		return data;
+	}
+
+	// View of the root object in place. Throws if the data was written with a different schema.
+	// Data must stay alive while views are used and be aligned at least as the root record.
+	template<Mirror::Mirrored Type>
+	static FlatView Open(std::span<const char> data) { return Open(Type::Meta::GetClass(), data); }
+
+	static FlatView Open(const Mirror::Class* cls, std::span<const char> data)
+	{
+		const FlatLayout& layout = FlatLayout::Get(cls);
+
+		Header header;
+		if (data.size() < sizeof(Header))
+			throw std::logic_error("Flat archive is truncated");
+		memcpy(&header, data.data(), sizeof(Header));
+
+		if (header.magic != magic)
+			throw std::logic_error("Data is not a flat archive");
+		if (header.schema != layout.schema)
+			throw std::logic_error(std::format("Flat archive schema doesn't match class '{}'", cls->Name()));
+		if (header.size > data.size() || header.root > header.size || header.size - header.root < layout.size)
+			throw std::logic_error("Flat archive is truncated");
+		if (uintptr_t(data.data()) % layout.alignment)
+			throw std::logic_error("Flat archive is not aligned");
+
+		std::span<const char> archive = data.first(size_t(header.size));
+		return FlatView(archive, archive.data() + header.root, &layout);
+	}
+};
+
+// Read-only memory mapping of an archive file, pages are loaded by the os on first access
+class FlatFile
+{
+	const char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE mapping = nullptr;
+#endif
+
+public:
+	explicit FlatFile(const std::filesystem::path& path)
+	{
+		size = size_t(std::filesystem::file_size(path));
+		if (size == 0) return;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::logic_error(std::format("Can't open '{}'", path.string()));
+
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping) data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			throw std::logic_error(std::format("Can't open '{}'", path.string()));
+
+		void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (memory != MAP_FAILED) data = (const char*)memory;
+#endif
+		if (!data)
+		{
+			Close();
+			throw std::logic_error(std::format("Can't map '{}'", path.string()));
+		}
+	}
+
+	FlatFile(const FlatFile&) = delete;
+	FlatFile& operator=(const FlatFile&) = delete;
+
+	~FlatFile() { Close(); }
+
+	std::span<const char> Data() const { return std::span(data, size); }
+
+	// View of the root object. Throws if the file was written with a different schema.
+	template<Mirror::Mirrored Type>
+	FlatView Root() const { return FlatArchive::Open<Type>(Data()); }
+
+private:
+	void Close()
+	{
+#ifdef _WIN32
+		if (data) UnmapViewOfFile(data);
+		if (mapping) CloseHandle(mapping);
+		mapping = nullptr;
+#else
+		if (data) munmap((void*)data, size);
+#endif
+		data = nullptr;
+	}
+};
+
+template<typename Type> requires (std::is_trivially_copyable_v<Type> && !std::is_pointer_v<Type> && !std::is_member_pointer_v<Type>
+	&& !Mirror::Mirrored<Type> && !Mirror::StlContainer<Type>)
+struct FlatValue<Type>
+{
+	static constexpr FlatKind kind = FlatKind::Scalar;
+	static size_t Size() { return sizeof(Type); }
+	static size_t Alignment() { return alignof(Type); }
+
+	static void Write(FlatWriter& writer, size_t position, const Type& value) { writer.WriteRaw(position, value); }
+};
+
+template<>
+struct FlatValue<std::string>
+{
+	static constexpr FlatKind kind = FlatKind::String;
+	static size_t Size() { return sizeof(FlatRef); }
+	static size_t Alignment() { return alignof(FlatRef); }
+
+	static void Write(FlatWriter& writer, size_t position, const std::string& str) { writer.WriteRaw(position, writer.WriteString(str)); }
+};
+
+template<Mirror::Mirrored Type>
+struct FlatValue<Type>
+{
+	static constexpr FlatKind kind = FlatKind::Record;
+
+	static const FlatLayout& Layout()
+	{
+		static const FlatLayout& layout = FlatLayout::Get(Type::Meta::GetClass());
+		return layout;
+	}
+
+	static size_t Size() { return Layout().size; }
+	static size_t Alignment() { return Layout().alignment; }
+
+	static void Write(FlatWriter& writer, size_t position, const Type& obj) { Layout().Write(writer, position, obj.GetThis()); }
+};
+
+// Sequences of scalars, strings and records. Contiguous scalars are copied in bulk.
+template<typename Type> requires (Mirror::StlContainer<Type> && !Mirror::StlString<Type> && !Mirror::Mirrored<Type> && !Mirror::StlMap<Type>
+	&& FlatValue<typename Type::value_type>::kind != FlatKind::None && FlatValue<typename Type::value_type>::kind != FlatKind::Array)
+struct FlatValue<Type>
+{
+	using Element = typename Type::value_type;
+
+	static constexpr FlatKind kind = FlatKind::Array;
+	static size_t Size() { return sizeof(FlatRef); }
+	static size_t Alignment() { return alignof(FlatRef); }
+
+	static void Write(FlatWriter& writer, size_t position, const Type& range)
+	{
+		size_t count = size_t(std::ranges::distance(range));
+		size_t stride = FlatValue<Element>::Size();
+		size_t data = writer.Allocate(count * stride, FlatValue<Element>::Alignment());
+
+		if constexpr (std::ranges::contiguous_range<Type> && FlatValue<Element>::kind == FlatKind::Scalar)
+			writer.WriteBytes(data, std::ranges::data(range), count * stride);
+		else
+			for (size_t i = 0; auto& value : range)
+				FlatValue<Element>::Write(writer, data + stride * i++, value);
+
+		writer.WriteRaw(position, FlatRef{data, count});
+	}
+};
\ No newline at end of file
@@ -4,10 +4,12 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <optional>
 
 #include "MirrorClass.h"
 #include "MirrorProperty.h"
 #include "MirrorMethod.h"
+#include "MirrorEnums.h"
 
 #include "lua.h"
 #include "lauxlib.h"
@@ -30,18 +32,38 @@ void LuaPush(lua_State* lua, Type&& value) { LuaValue<Type>::Push(lua, std::forw
 template<typename Type>
 Type LuaGet(lua_State* lua, int index) { return LuaValue<Type>::Get(lua, index); }
 
+// Read a value into existing storage. Types without an in-place reader are assigned a converted copy.
+template<typename Type>
+void LuaRead(lua_State* lua, int index, Type& value)
+{
+	if constexpr (requires { LuaValue<Type>::Read(lua, index, value); })
+		LuaValue<Type>::Read(lua, index, value);
+	else
+		value = LuaValue<Type>::Get(lua, index);
+}
+
 class LuaProperty : public virtual Mirror::Property
 {
 	void (LuaProperty::*push_value)(void*, lua_State*) const = nullptr;
 	void (LuaProperty::*read_value)(void*, lua_State*, int) const = nullptr;
 	std::any (*get_any)(lua_State*, int) = nullptr;
+	void* (*make_value)(lua_State*, int, void* (*)(void*), void*) = nullptr;
+	bool proxy = false;
 
 public:
 	template<typename Type>
 	void Pusher(void* obj, lua_State* lua) const { LuaValue<Type>::Push(lua, GetValue<Type>(obj)); }
 
+	// Data members without a custom setter are read in place
 	template<typename Type>
-	void Reader(void* obj, lua_State* lua, int index) const { SetValue(obj, LuaValue<Type>::Get(lua, index)); }
+	void Reader(void* obj, lua_State* lua, int index) const
+	{
+		if constexpr (std::is_move_assignable_v<Type>)
+			if (void* storage = GetStorage(obj))
+				return LuaRead(lua, index, *(Type*)storage);
+
+		SetValue(obj, LuaValue<Type>::Get(lua, index));
+	}
 
 	template<typename Type>
 	static std::any AnyGetter(lua_State* lua, int index)
@@ -49,6 +71,14 @@ public:
 		return std::make_any<Type>(Type(LuaValue<Type>::Get(lua, index)));
 	}
 
+	// Conversion errors raise Lua errors, so memory is requested with allocate(context) only after the value is converted
+	template<typename Type>
+	static void* ValueMaker(lua_State* lua, int index, void* (*allocate)(void*), void* context)
+	{
+		Type value(LuaValue<Type>::Get(lua, index));
+		return new (allocate(context)) Type(std::move(value));
+	}
+
 public:
 	template<typename Meta>
 	LuaProperty(Meta* meta) : Property(meta)
@@ -56,6 +86,10 @@ public:
 		if constexpr (LuaPushable<typename Meta::Type>)
 			push_value = &LuaProperty::Pusher<Meta::Type>;
 
+		// Nested structs marked "LuaProxy" are pushed as proxies reading and writing the live object in place
+		if constexpr (Mirror::Mirrored<typename Meta::Type> && !std::is_base_of_v<Mirror::IMirror, typename Meta::Type>)
+			proxy = inplace && meta_text.find("LuaProxy") != std::string::npos;
+
 		if (meta_text.find("LuaReadOnly") == std::string::npos)
 		{
 			if constexpr (LuaGettable<typename Meta::Type>)
@@ -63,10 +97,14 @@ public:
 
 			if constexpr (LuaGettable<typename Meta::Type> && Mirror::CopyConstructible<typename Meta::Type>)
 				get_any = &LuaProperty::AnyGetter<Meta::Type>;
+
+			if constexpr (LuaGettable<typename Meta::Type> && std::is_move_constructible_v<typename Meta::Type>)
+				make_value = &LuaProperty::ValueMaker<typename Meta::Type>;
 		}
 	}
 
 	using Mirror::Property::GetAny;
+	using Mirror::Property::GetRef;
 
 	std::any GetAny(lua_State* lua, int index) const
 	{
@@ -75,6 +113,24 @@ public:
 		return get_any(lua, index);
 	}
 
+	// Convert a Lua value into caller storage without a heap allocation for small types.
+	// A Lua error raised for an unconvertible value leaves the storage untouched.
+	template<size_t Capacity>
+	Mirror::ValueRef GetRef(lua_State* lua, int index, Mirror::ValueStorage<Capacity>& storage) const
+	{
+		if (!make_value)
+			throw std::logic_error(std::format("Property '{}' of type '{}' can not be read from Lua", name, type->name()));
+		using Context = std::pair<const LuaProperty*, Mirror::ValueStorage<Capacity>*>;
+		Context context(this, &storage);
+		void* memory = make_value(lua, index, [](void* ptr) -> void*
+		{
+			auto [property, storage] = *(Context*)ptr;
+			return storage->Allocate(property->size, property->alignment, property->type, property->destructor);
+		}, &context);
+		storage.Commit(memory);
+		return storage.GetRef();
+	}
+
 	void PushValue(void* obj, lua_State* lua) const
 	{
 		if (!push_value)
@@ -102,8 +158,20 @@ public:
 	bool CanPushValue() const { return push_value != nullptr; }
 	bool CanReadValue() const { return read_value != nullptr; }
 	bool CanGetAny() const { return get_any != nullptr; }
+	bool CanGetRef() const { return make_value != nullptr; }
+	bool IsProxy() const { return proxy; }
 };
 
+// Object of a userdata with a class metatable or nullptr
+inline Mirror::IMirror* LuaToObject(lua_State* lua, int index)
+{
+	void* data = lua_touserdata(lua, index);
+	if (!data || !lua_getmetatable(lua, index)) return nullptr;
+	bool reflected = lua_getfield(lua, -1, "__class") == LUA_TLIGHTUSERDATA;
+	lua_pop(lua, 2);
+	return reflected ? *(Mirror::IMirror**)data : nullptr;
+}
+
 struct LuaMethod : virtual Mirror::Method
 {
 	template<typename Signature, int N, int... Ns>
@@ -135,11 +203,11 @@ struct LuaMethod : virtual Mirror::Method
 		if (lua_gettop(lua) != sizeof...(Arguments) + 1)
 			luaL_error(lua, "Invalid number of arguments (%d/%d)", lua_gettop(lua), sizeof...(Arguments) + 1);
 
-		if (!lua_isuserdata(lua, 1))
+		Mirror::IMirror* obj = LuaToObject(lua, 1);
+		if (!obj)
 			luaL_argerror(lua, 1, "must be an object.");
 
 		Method* method = (LuaMethod*)lua_touserdata(lua, lua_upvalueindex(1));
-		Mirror::IMirror* obj = *(Mirror::IMirror**)lua_touserdata(lua, 1);
 
 		try
 		{
@@ -157,60 +225,196 @@ struct LuaMethod : virtual Mirror::Method
 	}
 };
 
-inline int LuaGetter(lua_State* lua)
+// Push a dispatch table of a class. Names are interned by Lua, so a field access is a single table lookup.
+// Property names map to LuaProperty light userdata, method names to closures shared by all objects of the class.
+inline void LuaPushDispatch(lua_State* lua, const Mirror::Class* cls, bool methods)
 {
-	std::string_view name = lua_tostring(lua, -1);
-	Mirror::IMirror* obj = *(Mirror::IMirror**)lua_touserdata(lua, -2);
-	if (!obj) luaL_error(lua, "Referring to a null object.");
-	Mirror::Class* cls = obj->GetClass();
+	lua_createtable(lua, 0, cls->PropertiesNum() + (methods ? cls->MethodsNum() : 0));
+	if (methods)
+	{
+		for (const LuaMethod* method : cls->Methods<LuaMethod>())
+		{
+			lua_pushlstring(lua, method->name.data(), method->name.size());
+			lua_pushlightuserdata(lua, (void*)method);
+			lua_pushcclosure(lua, method->invoke, 1);
+			lua_rawset(lua, -3);
+		}
+	}
 
-	const LuaProperty* property = nullptr;
-	const LuaMethod* method = nullptr;
+	// properties hide methods with the same name
+	for (const LuaProperty* property : cls->Properties<LuaProperty>())
+	{
+		lua_pushlstring(lua, property->name.data(), property->name.size());
+		lua_pushlightuserdata(lua, (void*)property);
+		lua_rawset(lua, -3);
+	}
+}
+
+// Proxy of a nested struct property marked "LuaProxy", reads and writes the live struct in place.
+// Proxies are cached in the user value table of their owner userdata, the table of a proxy keeps its owner alive.
+struct LuaProxy
+{
+	void* ptr; // the struct
+	void* parent; // object containing the struct
+	const LuaProperty* property;
+	const LuaProxy* outer; // proxy of the parent for nested structs, kept alive by the user value table
 
-	if (name.front() > 'Z')
+	static void Push(lua_State* lua, int owner, const LuaProperty* property, void* parent, const LuaProxy* outer = nullptr)
 	{
-		property = cls->GetProperty<LuaProperty>(name);
-		if (!property) method = cls->GetMethod<LuaMethod>(name);
+		owner = lua_absindex(lua, owner);
+		if (lua_getuservalue(lua, owner) != LUA_TTABLE)
+		{
+			lua_pop(lua, 1);
+			lua_newtable(lua);
+			lua_pushvalue(lua, -1);
+			lua_setuservalue(lua, owner);
+		}
+
+		if (lua_rawgetp(lua, -1, property) != LUA_TUSERDATA)
+		{
+			lua_pop(lua, 1);
+			LuaProxy* proxy = (LuaProxy*)lua_newuserdata(lua, sizeof(LuaProxy));
+			*proxy = {property->GetPointer(parent), parent, property, outer};
+
+			lua_createtable(lua, 1, 0);
+			lua_pushvalue(lua, owner);
+			lua_rawseti(lua, -2, 1);
+			lua_setuservalue(lua, -2);
+
+			PushMetatable(lua, property->ref_class);
+			lua_setmetatable(lua, -2);
+
+			lua_pushvalue(lua, -1);
+			lua_rawsetp(lua, -3, property);
+		}
+		lua_remove(lua, -2);
 	}
-	else
+
+	// Proxy of a userdata with a proxy metatable or nullptr
+	static LuaProxy* From(lua_State* lua, int index)
 	{
-		method = cls->GetMethod<LuaMethod>(name);
-		if (!method) property = cls->GetProperty<LuaProperty>(name);
+		void* data = lua_touserdata(lua, index);
+		if (!data || !lua_getmetatable(lua, index)) return nullptr;
+		bool proxy = lua_getfield(lua, -1, "__proxy") == LUA_TLIGHTUSERDATA;
+		lua_pop(lua, 2);
+		return proxy ? (LuaProxy*)data : nullptr;
 	}
 
-	if (property)
+	static int Index(lua_State* lua)
 	{
-		if (!property->CanPushValue())
-			luaL_error(lua, "field '%s' can not be read from lua", name.data());
-		property->PushValue(obj, lua);
+		LuaProxy* proxy = (LuaProxy*)lua_touserdata(lua, 1);
+		lua_pushvalue(lua, 2);
+		if (lua_rawget(lua, lua_upvalueindex(1)) != LUA_TLIGHTUSERDATA)
+			return luaL_error(lua, "field '%s' not found in '%s'", lua_tostring(lua, 2), proxy->property->ref_class->Name().data());
+
+		const LuaProperty* property = (const LuaProperty*)lua_touserdata(lua, -1);
+		if (property->IsProxy())
+			Push(lua, 1, property, proxy->ptr, proxy);
+		else if (property->CanPushValue())
+			property->PushValue(proxy->ptr, lua);
+		else
+			luaL_error(lua, "field '%s' can not be read from lua", property->name.data());
 		return 1;
 	}
 
-	if (method)
+	static int NewIndex(lua_State* lua)
+	{
+		LuaProxy* proxy = (LuaProxy*)lua_touserdata(lua, 1);
+		lua_pushvalue(lua, 2);
+		if (lua_rawget(lua, lua_upvalueindex(1)) != LUA_TLIGHTUSERDATA)
+			return luaL_error(lua, "Property '%s' not found in '%s'", lua_tostring(lua, 2), proxy->property->ref_class->Name().data());
+
+		const LuaProperty* property = (const LuaProperty*)lua_touserdata(lua, -1);
+		lua_pop(lua, 1);
+
+		if (!property->CanReadValue())
+			luaL_error(lua, "Property '%s' of type '%s' can not be written from lua", property->name.data(), property->type->name());
+		property->ReadValue(proxy->ptr, lua, 3);
+
+		// the write changes every struct up to the root object
+		for (const LuaProxy* link = proxy; link; link = link->outer)
+			link->property->MarkDirty(link->parent);
+
+		return 0;
+	}
+
+	// Proxy metatables are kept in the registry table "LuaProxy" by class
+	static void PushMetatable(lua_State* lua, const Mirror::Class* cls)
+	{
+		if (lua_getfield(lua, LUA_REGISTRYINDEX, "LuaProxy") != LUA_TTABLE)
+		{
+			lua_pop(lua, 1);
+			lua_newtable(lua);
+			lua_pushvalue(lua, -1);
+			lua_setfield(lua, LUA_REGISTRYINDEX, "LuaProxy");
+		}
+
+		if (lua_rawgetp(lua, -1, cls) != LUA_TTABLE)
+		{
+			lua_pop(lua, 1);
+			lua_createtable(lua, 0, 4);
+			lua_pushlstring(lua, cls->Name().data(), cls->Name().size());
+			lua_setfield(lua, -2, "__name");
+			lua_pushlightuserdata(lua, (void*)cls);
+			lua_setfield(lua, -2, "__proxy");
+
+			LuaPushDispatch(lua, cls, false);
+			lua_pushvalue(lua, -1);
+			lua_pushcclosure(lua, &LuaProxy::Index, 1);
+			lua_setfield(lua, -3, "__index");
+			lua_pushcclosure(lua, &LuaProxy::NewIndex, 1);
+			lua_setfield(lua, -2, "__newindex");
+
+			lua_pushvalue(lua, -1);
+			lua_rawsetp(lua, -3, cls);
+		}
+		lua_remove(lua, -2);
+	}
+};
+
+// Index handlers of class metatables get the class dispatch table as upvalue:
+// property names map to LuaProperty light userdata, method names to closures created once per class
+inline int LuaGetter(lua_State* lua)
+{
+	Mirror::IMirror* obj = *(Mirror::IMirror**)lua_touserdata(lua, 1);
+	if (!obj) luaL_error(lua, "Referring to a null object.");
+
+	lua_pushvalue(lua, 2);
+	switch (lua_rawget(lua, lua_upvalueindex(1)))
+	{
+	case LUA_TLIGHTUSERDATA:
 	{
-		lua_pushlightuserdata(lua, (void*)method);
-		lua_pushcclosure(lua, method->invoke, 1);
+		const LuaProperty* property = (const LuaProperty*)lua_touserdata(lua, -1);
+		if (property->IsProxy())
+			LuaProxy::Push(lua, 1, property, obj->GetThis());
+		else if (property->CanPushValue())
+			property->PushValue(obj, lua);
+		else
+			luaL_error(lua, "field '%s' can not be read from lua", property->name.data());
+		return 1;
+	}
+	case LUA_TFUNCTION:
 		return 1;
 	}
 
-	return luaL_error(lua, "field '%s' not found in '%s'", name.data(), cls->Name().data());
+	return luaL_error(lua, "field '%s' not found in '%s'", lua_tostring(lua, 2), obj->GetClass()->Name().data());
 }
 
 inline int LuaSetter(lua_State* lua)
 {
-	std::string_view name = lua_tostring(lua, -2);
-	Mirror::IMirror* obj = *(Mirror::IMirror**)lua_touserdata(lua, -3);
+	Mirror::IMirror* obj = *(Mirror::IMirror**)lua_touserdata(lua, 1);
 	if (!obj) luaL_error(lua, "Assigning to a null object.");
-	Mirror::Class* cls = obj->GetClass();
 
-	if (const LuaProperty* property = cls->GetProperty<LuaProperty>(name))
-	{
-		if (!property->CanReadValue())
-			luaL_error(lua, "Property '%s' of type '%s' can not be written from lua", property->name.data(), property->type->name());
-		property->ReadValue(obj, lua, -1);
-	}
-	else
-		luaL_error(lua, "Property '%s' not found in '%s'", name.data(), cls->Name().data());
+	lua_pushvalue(lua, 2);
+	if (lua_rawget(lua, lua_upvalueindex(1)) != LUA_TLIGHTUSERDATA)
+		return luaL_error(lua, "Property '%s' not found in '%s'", lua_tostring(lua, 2), obj->GetClass()->Name().data());
+
+	const LuaProperty* property = (const LuaProperty*)lua_touserdata(lua, -1);
+	lua_pop(lua, 1);
+
+	if (!property->CanReadValue())
+		luaL_error(lua, "Property '%s' of type '%s' can not be written from lua", property->name.data(), property->type->name());
+	property->ReadValue(obj, lua, 3);
 
 	return 0;
 }
@@ -225,8 +429,10 @@ inline int LuaDestructor(lua_State* lua)
 
 inline int LuaEqual(lua_State* lua)
 {
-	Mirror::IMirror* a = *(Mirror::IMirror**)luaL_checkudata(lua, 1, "Reflected");
-	Mirror::IMirror* b = *(Mirror::IMirror**)luaL_checkudata(lua, 2, "Reflected");
+	Mirror::IMirror* a = LuaToObject(lua, 1);
+	Mirror::IMirror* b = LuaToObject(lua, 2);
+	if (!a) luaL_argerror(lua, 1, "must be an object.");
+	if (!b) luaL_argerror(lua, 2, "must be an object.");
 	lua_settop(lua, 0);
 	lua_pushboolean(lua, a == b);
 	return 1;
@@ -284,6 +490,48 @@ inline void LuaBindDestructor(lua_State* lua, lua_CFunction destructor)
 	lua_pop(lua, 1);
 }
 
+// Push the metatable of a class. It is created on the first push of an object of the class and copies the handlers
+// bound to "Reflected", so bind them before pushing objects. C index handlers get the class dispatch table as upvalue.
+inline void LuaPushMetatable(lua_State* lua, const Mirror::Class* cls)
+{
+	if (lua_rawgetp(lua, LUA_REGISTRYINDEX, cls) != LUA_TNIL) return;
+	lua_pop(lua, 1);
+
+	lua_createtable(lua, 0, 6);
+	int metatable = lua_gettop(lua);
+	lua_pushlightuserdata(lua, (void*)cls);
+	lua_setfield(lua, metatable, "__class");
+	lua_pushlstring(lua, cls->Name().data(), cls->Name().size());
+	lua_setfield(lua, metatable, "__name");
+
+	LuaPushDispatch(lua, cls, true);
+
+	if (luaL_getmetatable(lua, "Reflected") == LUA_TTABLE)
+	{
+		for (const char* handler : { "__index", "__newindex" })
+		{
+			if (lua_getfield(lua, -1, handler) == LUA_TFUNCTION && lua_iscfunction(lua, -1))
+			{
+				lua_CFunction func = lua_tocfunction(lua, -1);
+				lua_pop(lua, 1);
+				lua_pushvalue(lua, metatable + 1);
+				lua_pushcclosure(lua, func, 1);
+			}
+			lua_setfield(lua, metatable, handler);
+		}
+
+		for (const char* handler : { "__eq", "__gc" })
+		{
+			lua_getfield(lua, -1, handler);
+			lua_setfield(lua, metatable, handler);
+		}
+	}
+
+	lua_settop(lua, metatable);
+	lua_pushvalue(lua, metatable);
+	lua_rawsetp(lua, LUA_REGISTRYINDEX, cls);
+}
+
 template<typename EnumType, typename... Others>
 void AddEnum(lua_State* lua) requires (sizeof...(Others) > 0)
 {
@@ -297,8 +545,33 @@ void AddEnum(lua_State* lua)
 	lua_newtable(lua);
 	for (auto [name, value] : Mirror::Enum<EnumType>::GetPairs())
 	{
+		// names are views into the enum declaration text and aren't null terminated
+		lua_pushlstring(lua, name.data(), name.size());
 		lua_pushnumber(lua, lua_Number(value));
-		lua_setfield(lua, -2, name.data());
+		lua_settable(lua, -3);
+	}
+
+	// Flags.ToString(value) and Flags.ToValue("A|B") for flags enums
+	if (Mirror::Flags<EnumType>::IsFlags())
+	{
+		lua_pushcfunction(lua, [](lua_State* lua) -> int
+		{
+			char buffer[256];
+			std::string fallback;
+			std::string_view text;
+			try { text = Mirror::Flags<EnumType>::ToString(EnumType(luaL_checkinteger(lua, 1)), buffer, fallback); }
+			catch (std::exception& ex) { return luaL_error(lua, "%s", ex.what()); }
+			lua_pushlstring(lua, text.data(), text.size());
+			return 1;
+		});
+		lua_setfield(lua, -2, "ToString");
+
+		lua_pushcfunction(lua, [](lua_State* lua) -> int
+		{
+			lua_pushinteger(lua, lua_Integer(LuaValue<EnumType>::Get(lua, 1)));
+			return 1;
+		});
+		lua_setfield(lua, -2, "ToValue");
 	}
 	lua_setglobal(lua, Mirror::Enum<EnumType>::GetName().data());
 };
@@ -315,6 +588,14 @@ struct LuaValue<std::string>
 	{
 		return !lua_isnil(lua, index) ? luaL_checkstring(lua, index) : std::string();
 	}
+
+	static void Read(lua_State* lua, int index, std::string& str)
+	{
+		if (lua_isnil(lua, index)) return str.clear();
+		size_t size;
+		const char* text = luaL_checklstring(lua, index, &size);
+		str.assign(text, size);
+	}
 };
 
 template<>
@@ -350,11 +631,24 @@ struct LuaValue<Type>
 	static Type Get(lua_State* lua, int index) { return (Type)luaL_checknumber(lua, index); }
 };
 
+// Flags enums can also be read from "A|B|C" strings
 template<typename Type> requires std::is_enum_v<Type>
 struct LuaValue<Type>
 {
 	static void Push(lua_State* lua, Type value) { lua_pushinteger(lua, int(value)); }
-	static Type Get(lua_State* lua, int index) { return (Type)luaL_checkinteger(lua, index); }
+
+	static Type Get(lua_State* lua, int index)
+	{
+		if (lua_type(lua, index) == LUA_TSTRING && Mirror::Flags<Type>::IsFlags())
+		{
+			size_t size;
+			const char* text = lua_tolstring(lua, index, &size);
+			std::optional<Type> value = Mirror::Flags<Type>::GetValue(std::string_view(text, size));
+			if (!value) luaL_argerror(lua, index, "invalid flags");
+			return *value;
+		}
+		return (Type)luaL_checkinteger(lua, index);
+	}
 };
 
 template<typename Type> requires std::is_convertible_v<Type*, Mirror::IMirror*>
@@ -366,7 +660,7 @@ struct LuaValue<Type*>
 		using Data = std::pair<const Mirror::IMirror*, bool>;
 		Data* data = (Data*)lua_newuserdata(lua, sizeof(Data));
 		*data = {iref, possess};
-		luaL_getmetatable(lua, "Reflected");
+		LuaPushMetatable(lua, iref->GetClass());
 		lua_setmetatable(lua, -2);
 	}
 
@@ -377,7 +671,8 @@ struct LuaValue<Type*>
 
 		if (lua_isnil(lua, index)) return nullptr;
 
-		Mirror::IMirror* obj = *(Mirror::IMirror**)lua_touserdata(lua, index);
+		Mirror::IMirror* obj = LuaToObject(lua, index);
+		if (!obj) luaL_argerror(lua, index, "not an object");
 		return dynamic_cast<Type*>(obj);
 	}
 };
@@ -444,9 +739,23 @@ struct LuaValue<Type>
 		if (!lua_isuserdata(lua, index) && !lua_istable(lua, index))
 			luaL_argerror(lua, index, "not an object. user data or table expected.");
 
+		// proxies are copied from the struct they refer to
+		if (LuaProxy* proxy = LuaProxy::From(lua, index))
+		{
+			const Mirror::Class* cls = Type::Meta::GetClass();
+			if (proxy->property->ref_class != cls)
+			{
+				const char* msg = lua_pushfstring(lua, "can't convert '%s' to '%s'", proxy->property->ref_class->Name().data(), cls->Name().data());
+				luaL_argerror(lua, index, msg);
+			}
+			return Type(*(Type*)proxy->ptr);
+		}
+
 		if (lua_isuserdata(lua, index))
 		{
-			Mirror::IMirror* iref = *(Mirror::IMirror**)lua_touserdata(lua, index);
+			Mirror::IMirror* iref = LuaToObject(lua, index);
+			if (!iref) luaL_argerror(lua, index, "not an object");
+
 			Type* src = dynamic_cast<Type*>(iref);
 			if (!src)
 			{
@@ -534,6 +843,30 @@ struct LuaValue<Array<Type, Others...>>
 
 		return Array<Type, Others...>(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
 	}
+
+	// Random access sequences reuse their elements, other sequences are refilled
+	static void Read(lua_State* lua, int index, Array<Type, Others...>& ar) requires LuaGettable<Type> && requires { { ar.emplace_back() } -> std::same_as<Type&>; ar.clear(); }
+	{
+		if (!lua_istable(lua, index))
+			luaL_argerror(lua, index, "not a table");
+
+		constexpr bool reuse = std::ranges::random_access_range<Array<Type, Others...>> && requires { ar.resize(size_t(0)); };
+		if constexpr (!reuse) ar.clear();
+
+		size_t count = 0;
+		lua_pushnil(lua);
+		while (lua_next(lua, index < 0 ? index - 1 : index))
+		{
+			if constexpr (reuse)
+				LuaRead(lua, -1, count < ar.size() ? ar[count] : ar.emplace_back());
+			else
+				LuaRead(lua, -1, ar.emplace_back());
+			count++;
+			lua_pop(lua, 1);
+		}
+
+		if constexpr (reuse) ar.resize(count);
+	}
 };
 
 template<typename Key, typename Value, template<typename...> class Map, typename... Others>
@@ -590,4 +923,18 @@ struct LuaValue<Map<Key, Value, Others...>>
 
 		return Map<Key, Value>(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
 	}
+
+	static void Read(lua_State* lua, int index, Map<Key, Value, Others...>& map) requires LuaGettable<Key> && LuaGettable<Value> && std::default_initializable<Value>
+	{
+		if (!lua_istable(lua, index))
+			luaL_argerror(lua, index, "not a table");
+
+		map.clear();
+		lua_pushnil(lua);
+		while (lua_next(lua, index < 0 ? index - 1 : index))
+		{
+			LuaRead(lua, -1, map.try_emplace(LuaValue<Key>::Get(lua, -2)).first->second);
+			lua_pop(lua, 1);
+		}
+	}
 };
\ No newline at end of file
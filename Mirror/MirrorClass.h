@@ -9,9 +9,17 @@
 #include <ranges>
 #include <optional>
 #include <type_traits>
+#include <mutex>
+#include <atomic>
 
 #include "MirrorProperty.h"
 #include "MirrorMethod.h"
+#include "MirrorTable.h"
+#include "MirrorPath.h"
+#include "MirrorCopy.h"
+#include "MirrorCompare.h"
+#include "MirrorDelta.h"
+#include "MirrorDirty.h"
 
 #ifdef _MSC_VER
 #	define MIRROR_FORCEDSPEC __declspec(noinline)
@@ -42,7 +50,16 @@
 		static const PropertyType* GetProperty(std::string_view name) { return cls->GetProperty<PropertyType>(name); } \
 		static const PropertyType* GetProperty(std::type_index t) { return cls->GetProperty<PropertyType>(t); } \
 		static const PropertyType* GetProperty(int index) { return cls->GetProperty<PropertyType>(index); } \
+		template<Mirror::StringLiteral Path> \
+		using PropertyMeta = Mirror::PropertyMeta<_Type_, Path>; \
+		template<Mirror::StringLiteral Name> \
+		static const PropertyType* GetProperty() \
+		{ \
+			static_assert(Name.Find('.') == std::string_view::npos, "Nested paths belong to nested classes, use Resolve or GetPath"); \
+			static const PropertyType* p = GetProperty(PropertyMeta<Name>::Name()); return p; \
+		} \
 		static std::vector<const Mirror::Property*> Resolve(const std::string& path) { return cls->Resolve(path); } \
+		static std::shared_ptr<const Mirror::PropertyPath> GetPath(std::string_view path) { return cls->GetPath(path); } \
 		template<typename PropertyType> \
 		static std::vector<const PropertyType*> Resolve(std::string_view path) { return cls->Resolve<PropertyType>(path); } \
 		static const MethodType* GetMethod(const std::string_view name) { return cls->GetMethod<const MethodType>(name); } \
@@ -81,9 +98,43 @@ namespace Mirror
 	template<typename Type, typename BaseList = void>
 	using GetBaseList = conditional_t<is_void_v<BaseList>, typename GetReflectedBaseList<Type>::BaseList, BaseList>;
 
+	template<typename Type, StringLiteral Name>
+	using DirectPropertyMeta = remove_pointer_t<decltype(xmirror_property(NameTag<Name>(), (remove_cvref_t<Type>*)nullptr))>;
+
+	template<typename Type, StringLiteral Path, size_t Dot = Path.Find('.')>
+	struct NestedPropertyMeta
+	{
+		using Head = DirectPropertyMeta<Type, Path.template Substr<0, Dot>()>;
+		using Meta = typename NestedPropertyMeta<typename Head::Type, Path.template Substr<Dot + 1, Path.Length() - Dot - 1>()>::Meta;
+	};
+
+	template<typename Type, StringLiteral Path>
+	struct NestedPropertyMeta<Type, Path, string_view::npos>
+	{
+		using Meta = DirectPropertyMeta<Type, Path>;
+	};
+
+	// Property meta struct generated by the property macro, resolved at compile time. Path may be nested: "snout.expression"
+	template<typename Type, StringLiteral Path>
+	using PropertyMeta = typename NestedPropertyMeta<Type, Path>::Meta;
+
 	template<typename From, typename To>
 	void* StaticCaster(void* ptr){ return (To*)(From*)ptr; }
 
+	template<typename>
+	struct MemberScope;
+
+	template<typename Scope, typename Member>
+	struct MemberScope<Member Scope::*> { using Type = Scope; };
+
+	// Offset of a base subobject, only meaningful for non-virtual bases
+	template<typename From, typename To>
+	ptrdiff_t StaticOffset()
+	{
+		From* ptr = (From*)FakeObject();
+		return (char*)(To*)ptr - (char*)ptr;
+	}
+
 	// Interface for abstract usage
 	class IMirror
 	{
@@ -99,14 +150,35 @@ namespace Mirror
 		const type_info* type;
 		vector<const Property*> properties;
 		vector<const Method*> methods;
-		unordered_multimap<string_view, const Property*> prop_map;
+		mutable NameTable<Property> prop_table;
 		unordered_multimap<type_index, const Property*> type_map;
-		unordered_multimap<string_view, const Method*> meth_map;
+		mutable NameTable<Method> meth_table;
+		mutable atomic<bool> sealed = false; // name tables are built on the first lookup after registration
+		mutable mutex tables_guard;
 
 		vector<Class*> bases, heirs;
 		unordered_map<const Class*, void*(*)(void*)> casters;
+		unordered_map<const Class*, ptrdiff_t> offsets; // heirs reaching this class by a non-virtual cast
 		
 		string_view name;
+
+		mutable PathCache paths;
+
+		ptrdiff_t dirty_offset = 0;
+		size_t dirty_words = 0; // zero if the class doesn't track dirty properties
+
+		// Copy plans by source class. The list is replaced as a whole when a plan is added, so readers don't lock.
+		struct CopyPlans
+		{
+			size_t generation;
+			vector<pair<const Class*, const CopyPlan*>> by_source;
+		};
+
+		mutable atomic<const CopyPlans*> copy_plans = nullptr;
+		mutable atomic<const pair<size_t, const ComparePlan*>*> compare_plan = nullptr; // with the generation it was built for
+		mutable vector<shared_ptr<const void>> published_plans; // everything ever published stays alive with the class
+		mutable mutex plans_guard;
+		static inline atomic<size_t> generation = 0; // changes whenever any class changes its properties
 		
 		void* (*make_default)() = nullptr;
 		IMirror* (*make_reflected)() = nullptr;
@@ -126,7 +198,20 @@ namespace Mirror
 					make_reflected = []()->IMirror* { return new Type(); };
 			}
 
+			if constexpr (DeclaresDirtyFlags<Type>)
+			{
+				static_assert(requires { &Type::xmirror_dirty; }, "Dirty flags are declared by more than one base class");
+				using Scope = typename MemberScope<decltype(&Type::xmirror_dirty)>::Type;
+				if constexpr (requires { static_cast<Type*>((Scope*)nullptr); })
+				{
+					char* object = (char*)FakeObject();
+					dirty_offset = StaticOffset<Type, Scope>() + ((char*)&((Scope*)object)->xmirror_dirty - object);
+					dirty_words = size(((Scope*)object)->xmirror_dirty.words);
+				}
+			}
+
 			Construct<Type>((typename Type::BaseList*)nullptr);
+			Update();
 		}
 
 		// Type name
@@ -158,8 +243,8 @@ namespace Mirror
 		// Get property by name
 		const Property* GetProperty(string_view property_name) const
 		{
-			auto property = prop_map.find(property_name);
-			return (property != prop_map.end()) ? property->second : nullptr;
+			Seal();
+			return prop_table.Find(property_name);
 		}
 
 		// Get property by name. Property pointer is cast to PropertyType.
@@ -213,14 +298,14 @@ namespace Mirror
 		}
 
 		// Resolve path to a property in nested structures
-		vector<const Property*> Resolve(string_view path)
+		vector<const Property*> Resolve(string_view path) const
 		{
 			return Resolve<Property>(path);
 		}
 
 		// Resolve path to a property in nested structures
 		template<typename PropertyType>
-		vector<const PropertyType*> Resolve(string_view path)
+		vector<const PropertyType*> Resolve(string_view path) const
 		{
 			vector<const PropertyType*> result;
 			size_t size = ranges::count(path, '.');
@@ -228,7 +313,7 @@ namespace Mirror
 			string property_name;
 			property_name.reserve(path.size());
 
-			Class* cls = this;
+			const Class* cls = this;
 			for (size_t off, pos = 0;; pos = off + 1)
 			{
 				off = path.find('.', pos);
@@ -242,18 +327,134 @@ namespace Mirror
 			}
 		}
 
+		// Compile path to a value in nested structures and containers into a reusable accessor.
+		// Path example: "items[3].pos.x", "table[\"key\"].value". Returns empty path if it can't be resolved.
+		PropertyPath Compile(string_view path) const
+		{
+			PropertyPath result;
+			const Class* cls = this;
+			const Container* container = nullptr;
+
+			for (size_t pos = 0; pos < path.size();)
+			{
+				if (path[pos] == '[')
+				{
+					if (!container) return {};
+
+					size_t close = path.find(']', pos);
+					string_view key = path.substr(pos + 1, close - pos - 1);
+					if (key.starts_with('"'))
+					{
+						size_t quote = path.find('"', pos + 2);
+						if (quote == string_view::npos) return {};
+						close = quote + 1;
+						key = path.substr(pos + 2, quote - pos - 2);
+					}
+					if (close >= path.size() || path[close] != ']') return {};
+
+					if (container->IsMap())
+					{
+						if (!result.Append(container, key)) return {};
+					}
+					else
+					{
+						size_t index;
+						auto [end, error] = from_chars(key.data(), key.data() + key.size(), index);
+						if (!container->at || error != errc() || end != key.data() + key.size()) return {};
+						result.Append(container, index);
+					}
+
+					cls = container->value_class ? container->value_class() : nullptr;
+					container = container->value_container;
+					pos = close + 1;
+				}
+				else
+				{
+					if (path[pos] == '.' && (pos == 0 || ++pos == path.size())) return {};
+
+					size_t end = min(path.find_first_of(".[", pos), path.size());
+					const Property* property = cls ? cls->GetProperty(path.substr(pos, end - pos)) : nullptr;
+					if (!property) return {};
+
+					result.Append(property);
+					cls = property->ref_class;
+					container = property->container;
+					pos = end;
+				}
+			}
+
+			return result;
+		}
+
+		// Get compiled path from the class cache. Returns null if the path can't be resolved.
+		shared_ptr<const PropertyPath> GetPath(string_view path) const
+		{
+			return paths.Get(path, [this](string_view path){ return Compile(path); });
+		}
+
+		// Get dirty flags of an object, empty view if the class doesn't track dirty properties
+		DirtyView GetDirty(void* ptr) const
+		{
+			if (!dirty_words) return {};
+			return DirtyView(span((uint64_t*)((char*)ptr + dirty_offset), dirty_words));
+		}
+
+		template<Mirrored Type>
+		DirtyView GetDirty(const Type& obj) const
+		{
+			return GetDirty(obj.GetThis());
+		}
+
+		// Call func(property) for each dirty property of an object in index order
+		template<typename Func>
+		void ForEachDirty(void* ptr, Func&& func) const
+		{
+			GetDirty(ptr).ForEach([&](size_t index){ func(properties[index]); });
+		}
+
+		// Get cached plan to copy properties of the src class into this class. Lock-free once the plan is built.
+		// The plan stays valid as long as the class, callers may keep it while the classes don't change.
+		const CopyPlan& GetCopyPlan(const Class* src) const
+		{
+			const CopyPlans* current = copy_plans.load(memory_order_acquire);
+			if (current && current->generation == generation.load(memory_order_acquire))
+				for (auto [source, plan] : current->by_source)
+					if (source == src) return *plan;
+
+			return BuildCopyPlan(src);
+		}
+
+		// Get cached plan to compare and hash objects of this class. Lock-free once the plan is built.
+		// The plan stays valid as long as the class, callers may keep it while the classes don't change.
+		const ComparePlan& GetComparePlan() const
+		{
+			const pair<size_t, const ComparePlan*>* current = compare_plan.load(memory_order_acquire);
+			if (current && current->first == generation.load(memory_order_acquire))
+				return *current->second;
+
+			return BuildComparePlan();
+		}
+
 		// Get method by name
-		template<typename MethodType>
+		template<typename MethodType> requires (!is_function_v<MethodType>)
 		const MethodType* GetMethod(string_view name) const
 		{
 			return dynamic_cast<const MethodType*>(GetMethod(name));
 		}
 
+		// Get method by name bound to the signature. Empty handle if not found, throws if the signature doesn't match.
+		template<typename Signature> requires is_function_v<Signature>
+		MethodHandle<Signature> GetMethod(string_view name) const
+		{
+			const Method* method = GetMethod(name);
+			return method ? method->Bind<Signature>() : MethodHandle<Signature>();
+		}
+
 		// Get method by name
 		const Method* GetMethod(string_view property_name) const
 		{
-			auto method = meth_map.find(property_name);
-			return (method != meth_map.end()) ? method->second : nullptr;
+			Seal();
+			return meth_table.Find(property_name);
 		}
 
 		template<typename PropertyType>
@@ -263,6 +464,7 @@ namespace Mirror
 			{
 				PropertyType* copy = new PropertyType(*property);
 				copy->caster = casters[*heir];
+				copy->Rebase(GetOffset(*heir));
 
 				auto& _properties = (*heir)->properties;
 				auto place = ranges::find_if(_properties.rbegin(), _properties.rend(), [&](auto& p){ return p->scope.type == type; }).base();
@@ -273,15 +475,15 @@ namespace Mirror
 						place = ranges::find_if(_properties, [&](auto& p){ return p->scope.type == (*it)->type; });
 				}
 
-				(*heir)->prop_map.emplace(copy->name, copy);
 				(*heir)->type_map.emplace(copy->type_id, copy);
 				(*heir)->properties.insert(place, copy);
+				(*heir)->Update();
 				(*heir)->NewProperty(copy);
 			}
 
-			prop_map.emplace(property->name, property);
 			type_map.emplace(property->type_id, property);
 			properties.push_back(property);
+			Update();
 
 			NewProperty(property);
 		}
@@ -293,6 +495,7 @@ namespace Mirror
 			{
 				MethodType* copy = new MethodType(*method);
 				copy->caster = casters[*heir];
+				copy->Rebase(GetOffset(*heir));
 
 				auto& _methods = (*heir)->methods;
 				auto place = ranges::find_if(_methods.rbegin(), _methods.rend(), [&](auto& p){ return p->scope.type == type; }).base();
@@ -303,13 +506,13 @@ namespace Mirror
 						place = find_if(_methods.begin(), _methods.end(), [&](auto& p){ return p->scope.type == (*it)->type; });
 				}
 
-				(*heir)->meth_map.emplace(copy->name, copy);
 				(*heir)->methods.insert(place, copy);
+				(*heir)->Update();
 				(*heir)->NewMethod(method);
 			}
 
-			meth_map.emplace(method->name, method);
 			methods.push_back(method);
+			Update();
 
 			NewMethod(method);
 		}
@@ -333,6 +536,13 @@ namespace Mirror
 		// Create an instance of the class if possible and return a pointer on interface
 		IMirror* MakeReflected() const { return make_reflected ? make_reflected() : nullptr; }
 
+		// Offset of this class within a heir or null if the heir can't be cast by a constant offset
+		const ptrdiff_t* GetOffset(const Class* heir) const
+		{
+			auto it = offsets.find(heir);
+			return it != offsets.end() ? &it->second : nullptr;
+		}
+
 		void* Cast(Class* heir, void* ptr) const
 		{
 			auto it = casters.find(heir);
@@ -356,7 +566,11 @@ namespace Mirror
 			{
 				void* (*caster)(void*) = nullptr;
 				if constexpr (is_convertible_v<Type*, Base*>)
+				{
 					caster = &StaticCaster<Type, Base>;
+					if constexpr (requires { static_cast<Type*>((Base*)nullptr); })
+						base->offsets.emplace(this, StaticOffset<Type, Base>());
+				}
 				
 				base->heirs.push_back(this);
 				if (caster) base->casters.emplace(this, caster);
@@ -367,7 +581,7 @@ namespace Mirror
 					{
 						Property* copy = property->copy(property);
 						copy->caster = caster;
-						prop_map.emplace(property->name, copy);
+						copy->Rebase(base->GetOffset(this));
 						type_map.emplace(property->type_id, copy);
 						properties.push_back(copy);
 					}
@@ -379,7 +593,7 @@ namespace Mirror
 					{
 						Method* copy = method->copy(method);
 						copy->caster = caster;
-						meth_map.emplace(method->name, copy);
+						copy->Rebase(base->GetOffset(this));
 						methods.push_back(copy);
 					}
 				}
@@ -394,24 +608,191 @@ namespace Mirror
 		template<typename>
 		void Construct(TypeList<>*, int = 0) {}
 
+		const CopyPlan& BuildCopyPlan(const Class* src) const
+		{
+			lock_guard lock(plans_guard);
+			size_t stamp = generation.load(memory_order_acquire);
+			const CopyPlans* current = copy_plans.load(memory_order_relaxed);
+			if (current && current->generation != stamp) current = nullptr;
+
+			if (current)
+				for (auto [source, plan] : current->by_source)
+					if (source == src) return *plan;
+
+			vector<pair<const Property*, const Property*>> pairs;
+			for (const Property* psrc : src->properties)
+			{
+				const Property* pdst = GetProperty(psrc->name);
+				assert(pdst && pdst->setter && pdst->scope.type_id == psrc->scope.type_id);
+				if (pdst) pairs.emplace_back(pdst, psrc);
+			}
+
+			auto plan = make_shared<const CopyPlan>(move(pairs));
+			auto plans = make_shared<CopyPlans>(CopyPlans{stamp, current ? current->by_source : vector<pair<const Class*, const CopyPlan*>>()});
+			plans->by_source.emplace_back(src, plan.get());
+
+			copy_plans.store(plans.get(), memory_order_release);
+			published_plans.push_back(plan);
+			published_plans.push_back(move(plans));
+			return *plan;
+		}
+
+		const ComparePlan& BuildComparePlan() const
+		{
+			lock_guard lock(plans_guard);
+			size_t stamp = generation.load(memory_order_acquire);
+			const pair<size_t, const ComparePlan*>* current = compare_plan.load(memory_order_relaxed);
+			if (current && current->first == stamp)
+				return *current->second;
+
+			auto plan = make_shared<const ComparePlan>(properties);
+			auto stamped = make_shared<const pair<size_t, const ComparePlan*>>(stamp, plan.get());
+
+			compare_plan.store(stamped.get(), memory_order_release);
+			published_plans.push_back(plan);
+			published_plans.push_back(move(stamped));
+			return *plan;
+		}
+
+		// Build name lookup tables once registration is complete
+		void Seal() const
+		{
+			if (sealed.load(memory_order_acquire)) return;
+
+			lock_guard lock(tables_guard);
+			if (sealed.load(memory_order_relaxed)) return;
+			prop_table.Build(properties);
+			meth_table.Build(methods);
+			sealed.store(true, memory_order_release);
+		}
+
+		// Index properties and schedule rebuilding of the name tables after properties or methods have changed
+		void Update()
+		{
+			sealed.store(false, memory_order_release);
+			++generation;
+
+			if (dirty_words && properties.size() > dirty_words * 64)
+				throw logic_error(format("Class '{}' has more properties than dirty flags ({})", name, dirty_words * 64));
+
+			for (size_t i = 0; i < properties.size(); i++)
+				const_cast<Property*>(properties[i])->Track(i, dirty_words ? &dirty_offset : nullptr);
+		}
+
 		virtual void NewProperty(const Property*) {}
 		virtual void NewMethod(const Method*) {}
 	};
 
-	// Copy object's properties one by one using getter and setter
+	// Copy object's properties using a plan cached for the pair of classes
 	template<typename Type, typename DstType>
 	void Copy(DstType& dest, const Type& src)
 	{
 		Type& dst = dest;
+		dst.GetClass()->GetCopyPlan(src.GetClass()).Apply(dst.GetThis(), src.GetThis());
+	}
+
+	// Check if objects are of the same class and all their comparable properties are equal
+	template<typename Type>
+	bool Equal(const Type& a, const Type& b)
+	{
+		const Class* cls = a.GetClass();
+		return cls == b.GetClass() && cls->GetComparePlan().Equal(a.GetThis(), b.GetThis());
+	}
+
+	// Compare objects property by property in declaration order. Objects of different classes are ordered by type.
+	template<typename Type>
+	int Compare(const Type& a, const Type& b)
+	{
+		const Class* cls = a.GetClass();
+		if (cls != b.GetClass()) return cls->GetType()->before(*b.GetClass()->GetType()) ? -1 : 1;
+		return cls->GetComparePlan().Compare(a.GetThis(), b.GetThis());
+	}
+
+	// Hash of all hashable properties, consistent with Equal
+	template<typename Type>
+	size_t Hash(const Type& obj)
+	{
+		return obj.GetClass()->GetComparePlan().Hash(obj.GetThis());
+	}
+
+	// Encode properties of obj that differ from baseline. Both objects must be of the same class.
+	template<typename Type>
+	Delta MakeDelta(const Type& obj, const Type& baseline)
+	{
+		const Class* cls = obj.GetClass();
+		assert(cls == baseline.GetClass());
+		return Delta(cls->GetType(), cls->GetComparePlan(), obj.GetThis(), baseline.GetThis());
+	}
+
+	// Read a delta written by Delta::Write for the class of the object
+	template<typename Type>
+	Delta ReadDelta(const Type& obj, span<const char> bytes)
+	{
+		return Delta::Read(obj.GetClass()->GetType(), bytes);
+	}
+
+	// Apply a delta made for the class of the object, e.g. to a copy of the baseline
+	template<typename Type>
+	void ApplyDelta(Type& obj, const Delta& delta)
+	{
+		const Class* cls = obj.GetClass();
+		if (delta.GetType() != cls->GetType())
+			throw logic_error(format("Delta made for '{}' can not be applied to '{}'", delta.GetType() ? delta.GetType()->name() : "null", cls->Name()));
+		delta.Apply(cls->Properties(), obj.GetThis());
+	}
 
-		for (const Property* psrc : src.GetClass()->Properties())
+	// Function objects to use reflected types as keys of hash containers
+	struct Hasher
+	{
+		template<typename Type>
+		size_t operator()(const Type& obj) const { return Hash(obj); }
+	};
+
+	struct EqualTo
+	{
+		template<typename Type>
+		bool operator()(const Type& a, const Type& b) const { return Equal(a, b); }
+	};
+
+	// Get value by name or nested path resolved at compile time
+	template<StringLiteral Path, typename Type>
+	decltype(auto) GetValue(Type& obj)
+	{
+		constexpr size_t dot = Path.Find('.');
+		if constexpr (dot == string_view::npos)
 		{
-			const Property* pdst = dst.GetClass()->GetProperty(psrc->name);
-			assert(pdst->setter && pdst->scope.type_id == psrc->scope.type_id);
+			using Meta = DirectPropertyMeta<Type, Path>;
+			return *(typename Meta::Type*)Meta::Access::Get((typename Meta::Scope*)&obj);
+		}
+		else
+			return GetValue<Path.template Substr<dot + 1, Path.Length() - dot - 1>()>(GetValue<Path.template Substr<0, dot>()>(obj));
+	}
+
+	// Set value by name or nested path resolved at compile time
+	template<StringLiteral Path, typename Type, typename ValueType>
+	void SetValue(Type& obj, ValueType&& value)
+	{
+		constexpr size_t dot = Path.Find('.');
+		if constexpr (dot == string_view::npos)
+		{
+			using Meta = DirectPropertyMeta<Type, Path>;
+			using PropertyType = typename Meta::Type;
+			void* scope = (typename Meta::Scope*)&obj;
+
+			if constexpr (!is_same_v<remove_cvref_t<ValueType>, PropertyType>)
+			{
+				PropertyType converted(forward<ValueType>(value));
+				Meta::Access::Move(scope, &converted);
+			}
+			else if constexpr (is_rvalue_reference_v<ValueType&&>)
+				Meta::Access::Move(scope, &value);
+			else
+				Meta::Access::Set(scope, (void*)&value);
 
-			void* value = psrc->getter(psrc->GetScope(src));
-			pdst->setter(pdst->GetScope(dst), value);
+			Type::Meta::template GetProperty<Path>()->MarkDirty((void*)&obj);
 		}
+		else
+			SetValue<Path.template Substr<dot + 1, Path.Length() - dot - 1>()>(GetValue<Path.template Substr<0, dot>()>(obj), forward<ValueType>(value));
 	}
 
 	// Set value by name
@@ -444,7 +825,9 @@ namespace Mirror
 	template<typename Type, typename ValueType>
 	void SetNestedValue(Type& obj, string_view path, ValueType&& value)
 	{
-		SetValue(obj.GetThis(), obj.GetClass()->Resolve(path), forward<ValueType>(value));
+		shared_ptr<const PropertyPath> compiled = obj.GetClass()->GetPath(path);
+		assert(compiled);
+		compiled->SetValue(obj.GetThis(), forward<ValueType>(value));
 	}
 
 	// Get value by name
@@ -474,7 +857,9 @@ namespace Mirror
 	template<typename ValueType, typename Type>
 	ValueType& GetNestedValue(Type& obj, string_view path)
 	{
-		return GetValue<ValueType>(obj.GetThis(), obj.GetClass()->Resolve(path));
+		shared_ptr<const PropertyPath> compiled = obj.GetClass()->GetPath(path);
+		assert(compiled);
+		return compiled->template GetValue<ValueType>(obj.GetThis());
 	}
 
 	// Find pointer to a nested structure following the specified properties
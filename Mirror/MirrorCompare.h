@@ -0,0 +1,285 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <functional>
+#include <concepts>
+#include <cstring>
+#include <cstdint>
+#include <span>
+#include <algorithm>
+
+#include "MirrorProperty.h"
+
+namespace Mirror
+{
+	using namespace std;
+
+	inline uint64_t HashMix(uint64_t value)
+	{
+		value *= 0xbf58476d1ce4e5b9ull;
+		return value ^ (value >> 31);
+	}
+
+	inline size_t HashCombine(size_t seed, size_t value)
+	{
+		return size_t(HashMix(seed ^ (value + 0x9e3779b97f4a7c15ull)));
+	}
+
+	// Hash raw bytes in four independent 64 bit lanes so that long blocks hash at memory speed
+	inline size_t HashBytes(const void* ptr, size_t size, size_t seed = 0)
+	{
+		const char* data = (const char*)ptr;
+		uint64_t lanes[4] = { seed + size, seed ^ 0x9e3779b97f4a7c15ull, seed ^ 0xc2b2ae3d27d4eb4full, seed ^ 0x165667b19e3779f9ull };
+		uint64_t word;
+
+		for (; size >= 32; data += 32, size -= 32)
+			for (int i = 0; i < 4; i++)
+			{
+				memcpy(&word, data + i * 8, 8);
+				lanes[i] = HashMix(lanes[i] ^ word);
+			}
+
+		for (int i = 0; size >= 8; data += 8, size -= 8, i++)
+		{
+			memcpy(&word, data, 8);
+			lanes[i] = HashMix(lanes[i] ^ word);
+		}
+
+		if (size)
+		{
+			word = 0;
+			memcpy(&word, data, size);
+			lanes[3] = HashMix(lanes[3] ^ word);
+		}
+
+		return size_t(HashMix(lanes[0] ^ HashMix(lanes[1] ^ HashMix(lanes[2] ^ lanes[3]))));
+	}
+
+	// Equality, ordering and hashing of property values.
+	// Reflected types are handled by their class compare plan, containers element by element.
+	template<typename Type>
+	struct Comparator
+	{
+		static constexpr bool can_equal = equality_comparable<Type>;
+		static constexpr bool can_compare = totally_ordered<Type>;
+		static constexpr bool can_hash = requires (const Type& value) { { hash<Type>()(value) } -> convertible_to<size_t>; };
+
+		static bool Equal(const Type& a, const Type& b) { return a == b; }
+		static int Compare(const Type& a, const Type& b) { return a < b ? -1 : b < a ? 1 : 0; }
+		static size_t Hash(const Type& value) { return hash<Type>()(value); }
+	};
+
+	template<Mirrored Type>
+	struct Comparator<Type>
+	{
+		static constexpr bool can_equal = true;
+		static constexpr bool can_compare = true;
+		static constexpr bool can_hash = true;
+
+		static bool Equal(const Type& a, const Type& b) { return Type::Meta::GetClass()->GetComparePlan().Equal(a.GetThis(), b.GetThis()); }
+		static int Compare(const Type& a, const Type& b) { return Type::Meta::GetClass()->GetComparePlan().Compare(a.GetThis(), b.GetThis()); }
+		static size_t Hash(const Type& value) { return Type::Meta::GetClass()->GetComparePlan().Hash(value.GetThis()); }
+	};
+
+	template<typename First, typename Second>
+	struct Comparator<pair<First, Second>>
+	{
+		using A = Comparator<remove_const_t<First>>;
+		using B = Comparator<Second>;
+
+		static constexpr bool can_equal = A::can_equal && B::can_equal;
+		static constexpr bool can_compare = A::can_compare && B::can_compare;
+		static constexpr bool can_hash = A::can_hash && B::can_hash;
+
+		static bool Equal(const pair<First, Second>& a, const pair<First, Second>& b) { return A::Equal(a.first, b.first) && B::Equal(a.second, b.second); }
+
+		static int Compare(const pair<First, Second>& a, const pair<First, Second>& b)
+		{
+			int result = A::Compare(a.first, b.first);
+			return result ? result : B::Compare(a.second, b.second);
+		}
+
+		static size_t Hash(const pair<First, Second>& value) { return HashCombine(A::Hash(value.first), B::Hash(value.second)); }
+	};
+
+	template<typename Type> requires (StlContainer<Type> && !StlString<Type> && !Mirrored<Type>)
+	struct Comparator<Type>
+	{
+		using Element = Comparator<typename Type::value_type>;
+		static constexpr bool unordered = requires { typename Type::hasher; };
+
+		static constexpr bool can_equal = Element::can_equal;
+		static constexpr bool can_compare = Element::can_compare && !unordered;
+		static constexpr bool can_hash = Element::can_hash;
+
+		static bool Equal(const Type& a, const Type& b)
+		{
+			if (ranges::distance(a) != ranges::distance(b)) return false;
+
+			// Elements with equal keys are adjacent, each group must be a permutation of the group in b
+			if constexpr (unordered)
+			{
+				for (auto it = a.begin(); it != a.end();)
+				{
+					auto [first, last] = a.equal_range(Key(*it));
+					auto [other, other_last] = b.equal_range(Key(*it));
+					if (!is_permutation(first, last, other, other_last, [](const auto& x, const auto& y){ return Element::Equal(x, y); }))
+						return false;
+					it = last;
+				}
+				return true;
+			}
+			else
+				return ranges::equal(a, b, [](const auto& x, const auto& y){ return Element::Equal(x, y); });
+		}
+
+		static int Compare(const Type& a, const Type& b)
+		{
+			auto x = a.begin(), y = b.begin();
+			for (; x != a.end() && y != b.end(); ++x, ++y)
+				if (int result = Element::Compare(*x, *y)) return result;
+			return (y != b.end()) ? -1 : (x != a.end()) ? 1 : 0;
+		}
+
+		// Unordered containers hash independently of the element order
+		static size_t Hash(const Type& value)
+		{
+			size_t result = size_t(ranges::distance(value));
+			for (const auto& element : value)
+				result = unordered ? result + HashMix(Element::Hash(element)) : HashCombine(result, Element::Hash(element));
+			return result;
+		}
+
+	private:
+		template<typename Value>
+		static auto& Key(const Value& value)
+		{
+			if constexpr (StlMap<Type>) return value.first;
+			else return value;
+		}
+	};
+
+	// Precompiled structural equality, ordering and hashing of a class.
+	// Adjacent plain fields with unique object representations are compared with memcmp and hashed as a block.
+	class ComparePlan
+	{
+		struct Block
+		{
+			ptrdiff_t offset;
+			size_t size;
+			size_t first, count; // range of packed properties
+		};
+
+		vector<Block> blocks;
+		vector<const Property*> packed; // properties within blocks sorted by offset
+		vector<const Property*> fields; // compared one by one for equality and hashing
+		vector<const Property*> ordered; // all comparable properties in declaration order
+
+	public:
+		ComparePlan() = default;
+
+		template<PropertyRange Range>
+		explicit ComparePlan(const Range& properties)
+		{
+			for (const Property* property : properties)
+			{
+				if (property->compare) ordered.push_back(property);
+
+				if (property->plain && property->unique_representation)
+					packed.push_back(property);
+				else if (property->equal)
+					fields.push_back(property);
+			}
+
+			ranges::sort(packed, {}, [](const Property* p){ return p->offset; });
+			for (size_t i = 0; i < packed.size(); i++)
+			{
+				const Property* property = packed[i];
+				if (!blocks.empty() && blocks.back().offset + ptrdiff_t(blocks.back().size) == property->offset)
+				{
+					blocks.back().size += property->size;
+					blocks.back().count++;
+				}
+				else
+					blocks.push_back({property->offset, property->size, i, 1});
+			}
+		}
+
+		// Check equality of two objects of the class, pointers are returned by GetThis()
+		bool Equal(void* a, void* b) const
+		{
+			for (const Block& block : blocks)
+				if (memcmp((char*)a + block.offset, (char*)b + block.offset, block.size) != 0)
+					return false;
+
+			ValueStorage<> storage;
+			for (const Property* property : fields)
+				if (!property->equal(Read(property, a, storage), property->getter(property->GetScope(b))))
+					return false;
+
+			return true;
+		}
+
+		// Compare two objects of the class property by property in declaration order
+		int Compare(void* a, void* b) const
+		{
+			ValueStorage<> storage;
+			for (const Property* property : ordered)
+			{
+				if (property->plain)
+				{
+					const char* x = (char*)a + property->offset;
+					const char* y = (char*)b + property->offset;
+					if (property->unique_representation && memcmp(x, y, property->size) == 0) continue;
+					if (int result = property->compare(x, y)) return result;
+				}
+				else if (int result = property->compare(Read(property, a, storage), property->getter(property->GetScope(b))))
+					return result;
+			}
+			return 0;
+		}
+
+		// Call changed(property) for each comparable property that differs, equal blocks are skipped with a single memcmp
+		template<typename Func>
+		void Diff(void* a, void* b, Func&& changed) const
+		{
+			for (const Block& block : blocks)
+			{
+				if (memcmp((char*)a + block.offset, (char*)b + block.offset, block.size) == 0) continue;
+
+				for (const Property* property : span(packed).subspan(block.first, block.count))
+					if (memcmp((char*)a + property->offset, (char*)b + property->offset, property->size) != 0)
+						changed(property);
+			}
+
+			ValueStorage<> storage;
+			for (const Property* property : fields)
+				if (!property->equal(Read(property, a, storage), property->getter(property->GetScope(b))))
+					changed(property);
+		}
+
+		// Hash consistent with Equal
+		size_t Hash(void* obj) const
+		{
+			size_t result = 0;
+			for (const Block& block : blocks)
+				result = HashBytes((char*)obj + block.offset, block.size, result);
+
+			for (const Property* property : fields)
+				if (property->hash)
+					result = HashCombine(result, property->hash(property->getter(property->GetScope(obj))));
+
+			return result;
+		}
+
+	private:
+		// Getters may return a temporary shared by all values of the type, so the first operand is copied
+		static const void* Read(const Property* property, void* obj, ValueStorage<>& storage)
+		{
+			if (property->plain) return (char*)obj + property->offset;
+			if (property->copier) return property->CopyValue(obj, storage);
+			return property->getter(property->GetScope(obj));
+		}
+	};
+}
\ No newline at end of file
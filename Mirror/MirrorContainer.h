@@ -0,0 +1,168 @@
+#pragma once
+
+#include <typeinfo>
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <charconv>
+#include <ranges>
+#include <memory>
+
+#include "MirrorTools.h"
+
+namespace Mirror
+{
+	using namespace std;
+
+	class Class;
+
+	// Type-erased access to an stl container
+	struct Container
+	{
+		const type_info* value_type = nullptr; // element type, mapped type for maps
+		const type_info* key_type = nullptr; // key type for maps
+		Class* (*value_class)() = nullptr; // class of reflected elements
+		const Container* value_container = nullptr; // elements are containers too
+
+		size_t (*size)(void*) = nullptr;
+		void* (*at)(void*, size_t) = nullptr; // element by position, null if out of range
+		shared_ptr<const void> (*parse_key)(string_view) = nullptr; // map key parsed from text, null if the text isn't a valid key
+		void* (*find)(void*, const void*) = nullptr; // mapped value by key, null if not found
+		void (*iterate)(void*, void*, void (*)(void*, const void*, void*)) = nullptr; // visit(context, key, element) for each element, key is null for non-maps, null if elements have no address
+		void (*reserve)(void*, size_t) = nullptr; // null if the container can't reserve
+		void (*clear)(void*) = nullptr;
+		void* (*emplace_back)(void*) = nullptr; // append a default constructed element and return it
+		void* (*emplace)(void*, const void*) = nullptr; // mapped value by key, default constructed if the key is new
+		bool (*insert)(void*, void*) = nullptr; // move a value into an associative container, false if it was already there
+
+		bool IsMap() const { return key_type != nullptr; }
+
+		// Call func(key, element) for each element in container order. Key is null for non-maps, set elements must not be modified.
+		template<typename Func>
+		void ForEach(void* ptr, Func&& func) const
+		{
+			iterate(ptr, (void*)&func, [](void* context, const void* key, void* element){ (*(remove_reference_t<Func>*)context)(key, element); });
+		}
+	};
+
+	template<typename Type>
+	concept StlString = requires { typename Type::traits_type; };
+
+	// Parse key text into a map key
+	template<typename Type>
+	bool ParseKey(string_view text, Type& key)
+	{
+		if constexpr (is_constructible_v<Type, string_view>)
+		{
+			key = Type(text);
+			return true;
+		}
+		else if constexpr ((is_integral_v<Type> && !is_same_v<Type, bool>) || is_floating_point_v<Type>)
+		{
+			auto [end, error] = from_chars(text.data(), text.data() + text.size(), key);
+			return error == errc() && end == text.data() + text.size();
+		}
+		else if constexpr (is_enum_v<Type>)
+		{
+			underlying_type_t<Type> value;
+			if (!ParseKey(text, value)) return false;
+			key = Type(value);
+			return true;
+		}
+		else
+			return false;
+	}
+
+	// Element type of a container, mapped type for maps
+	template<typename Type>
+	struct ElementOf { using type = typename Type::value_type; };
+
+	template<StlMap Type>
+	struct ElementOf<Type> { using type = typename Type::mapped_type; };
+
+	template<typename Type>
+	struct ContainerOf
+	{
+		static inline const Container* instance = nullptr;
+	};
+
+	template<typename Type> requires (StlContainer<Type> && !StlString<Type>)
+	struct ContainerOf<Type>
+	{
+		using Value = typename ElementOf<Type>::type;
+
+		static Container Make()
+		{
+			Container container;
+			container.value_type = &typeid(Value);
+			container.value_container = ContainerOf<Value>::instance;
+			container.size = [](void* ptr){ return size_t(ranges::distance(*(Type*)ptr)); };
+
+			// elements accessed through proxies like in vector<bool> have no address
+			if constexpr (is_reference_v<decltype(*begin(declval<Type&>()))>)
+			{
+				container.iterate = [](void* ptr, void* context, void (*visit)(void*, const void*, void*))
+				{
+					for (auto& element : *(Type*)ptr)
+					{
+						if constexpr (StlMap<Type>) visit(context, &element.first, (void*)&element.second);
+						else visit(context, nullptr, (void*)&element);
+					}
+				};
+			}
+
+			if constexpr (requires (Type& c) { c.reserve(size_t(0)); })
+				container.reserve = [](void* ptr, size_t count){ ((Type*)ptr)->reserve(count); };
+
+			if constexpr (requires (Type& c) { c.clear(); })
+				container.clear = [](void* ptr){ ((Type*)ptr)->clear(); };
+
+			if constexpr (requires (Type& c) { { c.emplace_back() } -> same_as<Value&>; })
+				container.emplace_back = [](void* ptr) -> void* { return &((Type*)ptr)->emplace_back(); };
+
+			if constexpr (requires (Type& c, const typename Type::key_type& key) { c.try_emplace(key); })
+				container.emplace = [](void* ptr, const void* key) -> void* { return &((Type*)ptr)->try_emplace(*(const typename Type::key_type*)key).first->second; };
+
+			if constexpr (requires (Type& c, typename Type::value_type&& value) { c.insert(move(value)).second; })
+				container.insert = [](void* ptr, void* value){ return ((Type*)ptr)->insert(move(*(typename Type::value_type*)value)).second; };
+
+			if constexpr (Mirrored<Value>)
+				container.value_class = []() -> Class* { return Value::Meta::GetClass(); };
+
+			if constexpr (StlMap<Type>)
+			{
+				container.key_type = &typeid(typename Type::key_type);
+				container.parse_key = [](string_view text) -> shared_ptr<const void>
+				{
+					auto key = make_shared<typename Type::key_type>();
+					if (!ParseKey(text, *key)) return nullptr;
+					return key;
+				};
+				container.find = [](void* ptr, const void* key) -> void*
+				{
+					Type& map = *(Type*)ptr;
+					auto it = map.find(*(const typename Type::key_type*)key);
+					return it != map.end() ? &it->second : nullptr;
+				};
+			}
+			else if constexpr (!requires { typename Type::key_type; } && is_reference_v<decltype(*begin(declval<Type&>()))>)
+			{
+				container.at = [](void* ptr, size_t index) -> void*
+				{
+					Type& sequence = *(Type*)ptr;
+					if (index >= size_t(ranges::distance(sequence))) return nullptr;
+					return (void*)&*next(begin(sequence), index);
+				};
+			}
+
+			return container;
+		}
+
+		static inline const Container storage = Make();
+		static inline const Container* instance = &storage;
+	};
+
+	// Get type-erased container access or null if the type is not a container
+	template<typename Type>
+	const Container* GetContainer() { return ContainerOf<Type>::instance; }
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+
+#include "MirrorProperty.h"
+
+namespace Mirror
+{
+	using namespace std;
+
+	// Precompiled copy of matching properties from one class to another.
+	// Adjacent plain trivially copyable fields are copied as one memcpy block, the rest go through getter and setter.
+	class CopyPlan
+	{
+		struct Block
+		{
+			ptrdiff_t dst;
+			ptrdiff_t src;
+			size_t size;
+		};
+
+		struct Field
+		{
+			const Property* dst;
+			const Property* src;
+		};
+
+		vector<Block> blocks;
+		vector<Field> fields;
+		vector<const Property*> tracked; // destination properties with dirty flags
+
+	public:
+		CopyPlan() = default;
+
+		// Build from pairs of destination and source properties
+		explicit CopyPlan(vector<pair<const Property*, const Property*>> pairs)
+		{
+			auto block = [](const pair<const Property*, const Property*>& p)
+			{
+				auto [dst, src] = p;
+				return dst->plain && src->plain && dst->trivially_copyable && dst->type_id == src->type_id;
+			};
+
+			auto split = ranges::stable_partition(pairs, block);
+			ranges::sort(pairs.begin(), split.begin(), {}, [](auto& p){ return p.second->offset; });
+
+			for (auto it = pairs.begin(); it != split.begin(); ++it)
+			{
+				auto [dst, src] = *it;
+				if (!blocks.empty())
+				{
+					Block& last = blocks.back();
+					if (last.src + ptrdiff_t(last.size) == src->offset && last.dst + ptrdiff_t(last.size) == dst->offset)
+					{
+						last.size += src->size;
+						continue;
+					}
+				}
+				blocks.push_back({dst->offset, src->offset, src->size});
+			}
+
+			for (auto it = split.begin(); it != split.end(); ++it)
+				fields.push_back({it->first, it->second});
+
+			for (auto [dst, src] : pairs)
+				if (dst->tracked) tracked.push_back(dst);
+		}
+
+		// Copy from src to dst, both are pointers returned by GetThis()
+		void Apply(void* dst, void* src) const
+		{
+			for (const Block& block : blocks)
+				memcpy((char*)dst + block.dst, (char*)src + block.src, block.size);
+
+			for (const Field& field : fields)
+			{
+				void* value = field.src->getter(field.src->GetScope(src));
+				field.dst->setter(field.dst->GetScope(dst), value);
+			}
+
+			for (const Property* property : tracked)
+				property->MarkDirty(dst);
+		}
+
+		// Number of memcpy blocks
+		size_t BlocksNum() const { return blocks.size(); }
+
+		// Number of properties copied by getter and setter
+		size_t FieldsNum() const { return fields.size(); }
+	};
+}
\ No newline at end of file
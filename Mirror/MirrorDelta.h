@@ -0,0 +1,204 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <ranges>
+#include <cstring>
+#include <stdexcept>
+
+#include "MirrorCompare.h"
+
+namespace Mirror
+{
+	using namespace std;
+
+	// Property mixin encoding values to bytes, lets deltas hold values that aren't plain trivially copyable
+	class DeltaCodec
+	{
+	public:
+		virtual ~DeltaCodec() = default;
+
+		virtual bool CanEncodeValue() const = 0;
+
+		// Append the value of the property of obj to data
+		virtual void EncodeValue(void* obj, vector<char>& data) const = 0;
+
+		// Set the property of obj from the bytes of a value written by EncodeValue
+		virtual void DecodeValue(void* obj, span<const char> bytes) const = 0;
+	};
+
+	// Difference of an object from a baseline of the same class: indices of changed properties and their values as bytes.
+	// Plain trivially copyable values are stored as raw bytes, other values are encoded by the DeltaCodec of the property.
+	// Only properties passing Supports() are recorded, others are skipped: a delta applied to a copy of the baseline
+	// reproduces the object in supported properties and leaves the rest as in the baseline.
+	class Delta
+	{
+		struct Change
+		{
+			uint32_t index; // property index in the class
+			uint32_t offset; // payload position in data
+			uint32_t size; // payload size
+		};
+
+		const type_info* type = nullptr;
+		vector<Change> changes;
+		vector<char> data;
+
+	public:
+		Delta() = default;
+
+		// Encode properties of obj that differ from baseline. Both are pointers returned by GetThis() of objects of the class.
+		Delta(const type_info* class_type, const ComparePlan& plan, void* obj, void* baseline) : type(class_type)
+		{
+			plan.Diff(obj, baseline, [&](const Property* property)
+			{
+				if (!Supports(property)) return;
+
+				size_t offset = data.size();
+				if (Raw(property))
+				{
+					const char* bytes = (char*)obj + property->offset;
+					data.insert(data.end(), bytes, bytes + property->size);
+				}
+				else
+					dynamic_cast<const DeltaCodec*>(property)->EncodeValue(obj, data);
+
+				changes.push_back({property->index, uint32_t(offset), uint32_t(data.size() - offset)});
+			});
+
+			// payloads follow the index order, so the serialized form only needs their sizes
+			if (ranges::is_sorted(changes, {}, &Change::index)) return;
+			ranges::sort(changes, {}, &Change::index);
+
+			vector<char> ordered;
+			ordered.reserve(data.size());
+			for (Change& change : changes)
+			{
+				ordered.insert(ordered.end(), data.begin() + change.offset, data.begin() + change.offset + change.size);
+				change.offset = uint32_t(ordered.size() - change.size);
+			}
+			data = move(ordered);
+		}
+
+		// Apply changes to an object of the class the delta was made for, properties are the class properties.
+		// Throws if the delta doesn't fit the properties, e.g. if it was read from data of another class version.
+		template<PropertyRange Range>
+		void Apply(const Range& properties, void* obj) const
+		{
+			for (const Change& change : changes)
+			{
+				if (change.index >= ranges::size(properties))
+					throw logic_error(format("Delta changes property {} of a class with {} properties", change.index, ranges::size(properties)));
+
+				const Property* property = properties[change.index];
+				span<const char> bytes(data.data() + change.offset, change.size);
+				if (Raw(property))
+				{
+					if (bytes.size() != property->size)
+						throw logic_error(format("Delta value of '{}' has a wrong size", property->name));
+					memcpy((char*)obj + property->offset, bytes.data(), bytes.size());
+				}
+				else if (const DeltaCodec* codec = Supports(property) ? dynamic_cast<const DeltaCodec*>(property) : nullptr)
+					codec->DecodeValue(obj, bytes);
+				else
+					throw logic_error(format("Delta can't set property '{}'", property->name));
+
+				property->MarkDirty(obj);
+			}
+		}
+
+		// Property can be recorded: its values can be compared to find changes, and encoded into the delta and set back.
+		// Plain trivially copyable values are copied as bytes, others need a DeltaCodec mixin. Values without unique bytes need equal.
+		static bool Supports(const Property* property)
+		{
+			if (Raw(property)) return property->unique_representation || property->equal;
+			const DeltaCodec* codec = dynamic_cast<const DeltaCodec*>(property);
+			return property->equal && codec && codec->CanEncodeValue();
+		}
+
+		// Serialized delta: varint count, varint index and size of each change, then the payloads.
+		// The class isn't stored, the reader must know it like with the in-memory type check.
+		vector<char> Write() const
+		{
+			vector<char> bytes;
+			WriteVarint(bytes, changes.size());
+			for (const Change& change : changes)
+			{
+				WriteVarint(bytes, change.index);
+				WriteVarint(bytes, change.size);
+			}
+			bytes.insert(bytes.end(), data.begin(), data.end());
+			return bytes;
+		}
+
+		// Read a delta written by Write for the class of class_type. Throws on truncated or corrupt data.
+		static Delta Read(const type_info* class_type, span<const char> bytes)
+		{
+			Delta delta;
+			delta.type = class_type;
+
+			uint64_t count = ReadVarint(bytes);
+			if (count > bytes.size())
+				throw logic_error("Delta data is truncated");
+
+			uint64_t offset = 0;
+			for (uint64_t i = 0; i < count; i++)
+			{
+				uint64_t index = ReadVarint(bytes);
+				uint64_t size = ReadVarint(bytes);
+				if (index > UINT32_MAX || (!delta.changes.empty() && index <= delta.changes.back().index))
+					throw logic_error("Delta data has invalid property indices");
+				if (size > UINT32_MAX - offset)
+					throw logic_error("Delta data is truncated");
+
+				delta.changes.push_back({uint32_t(index), uint32_t(offset), uint32_t(size)});
+				offset += size;
+			}
+
+			if (offset != bytes.size())
+				throw logic_error("Delta data is truncated");
+			delta.data.assign(bytes.begin(), bytes.end());
+			return delta;
+		}
+
+		// Type of the class the delta was made for
+		const type_info* GetType() const { return type; }
+
+		// Number of changed properties
+		size_t Size() const { return changes.size(); }
+
+		bool Empty() const { return changes.empty(); }
+
+		// Indices of changed properties in ascending order
+		auto Indices() const { return changes | views::transform(&Change::index); }
+
+		// Payloads of all changes in index order
+		span<const char> Data() const { return data; }
+
+	private:
+		static bool Raw(const Property* property)
+		{
+			return property->plain && property->trivially_copyable;
+		}
+
+		static void WriteVarint(vector<char>& bytes, uint64_t value)
+		{
+			for (; value >= 0x80; value >>= 7)
+				bytes.push_back(char(value | 0x80));
+			bytes.push_back(char(value));
+		}
+
+		static uint64_t ReadVarint(span<const char>& bytes)
+		{
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64 && !bytes.empty(); shift += 7)
+			{
+				uint8_t byte = uint8_t(bytes.front());
+				bytes = bytes.subspan(1);
+				value |= uint64_t(byte & 0x7f) << shift;
+				if (!(byte & 0x80)) return value;
+			}
+			throw logic_error("Delta data has an invalid varint");
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <span>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+// Opt-in per object flags of properties written through reflection. Capacity is the max number of properties.
+#define MIRROR_DIRTY_FLAGS(...) \
+	Mirror::DirtyFlags<__VA_ARGS__> xmirror_dirty; \
+	friend class Mirror::Class
+
+namespace Mirror
+{
+	using namespace std;
+
+	class Class;
+
+	struct DirtyProbe { int xmirror_dirty; };
+
+	template<typename Type>
+	struct DirtyProbeOf : Type, DirtyProbe {};
+
+	// Dirty flags declared by the class or its bases. The name is ambiguous in the probe whenever the class has it,
+	// so flags reached through two bases are detected too.
+	template<typename Type>
+	concept DeclaresDirtyFlags = requires { &Type::xmirror_dirty; } || (!is_final_v<Type> && !requires { &DirtyProbeOf<Type>::xmirror_dirty; });
+
+	// Type-erased access to dirty flags of an object, bits follow the property order of the object's class
+	class DirtyView
+	{
+		span<uint64_t> words;
+
+	public:
+		DirtyView() = default;
+		explicit DirtyView(span<uint64_t> words) : words(words) {}
+
+		bool Test(size_t index) const { return words[index / 64] >> (index % 64) & 1; }
+		void Set(size_t index) { words[index / 64] |= 1ull << (index % 64); }
+		void Reset(size_t index) { words[index / 64] &= ~(1ull << (index % 64)); }
+
+		// Check if any property is dirty
+		bool Any() const { return ranges::any_of(words, [](uint64_t word){ return word != 0; }); }
+
+		// Clear all flags
+		void Clear() { ranges::fill(words, 0); }
+
+		// Call func(index) for each dirty property in index order
+		template<typename Func>
+		void ForEach(Func&& func) const
+		{
+			for (size_t i = 0; i < words.size(); i++)
+				for (uint64_t word = words[i]; word; word &= word - 1)
+					func(i * 64 + countr_zero(word));
+		}
+
+		// False if the class doesn't track dirty properties
+		explicit operator bool() const { return !words.empty(); }
+	};
+
+	template<size_t Capacity = 64>
+	struct DirtyFlags
+	{
+		uint64_t words[(Capacity + 63) / 64] = {};
+
+		DirtyView View() const { return DirtyView(span((uint64_t*)words, size(words))); }
+
+		bool Test(size_t index) const { return View().Test(index); }
+		bool Any() const { return View().Any(); }
+		void Clear() { View().Clear(); }
+
+		template<typename Func>
+		void ForEach(Func&& func) const { View().ForEach(forward<Func>(func)); }
+	};
+}
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <vector>
-#include <unordered_map>
+#include <span>
+#include <ranges>
+#include <algorithm>
 #include <optional>
 #include <format>
+#include <bit>
+
+#include "MirrorTable.h"
 
 #define MIRROR_ENUM(_Type_, _Storage_, ...) __VA_ARGS__ }; \
 	struct xmirror_##_Type_##_meta \
@@ -28,6 +33,32 @@
 		return &Mirror::StaticInstance<Mirror::Executor<&xmirror_##_Type_##_constructor>>::instance; \
 	}
 
+// Enum of bit flags, values are converted to and from names of their bits separated by '|'
+#define MIRROR_FLAGS_ENUM(_Type_, _Storage_, ...) __VA_ARGS__ }; \
+	struct xmirror_##_Type_##_meta \
+	{ \
+		struct Values { int64_t __VA_ARGS__; }; \
+		static inline _Storage_ Mirror::TFlags<_Type_, Values> instance = Mirror::TFlags<_Type_, Values>(#_Type_, #__VA_ARGS__); \
+	}; \
+	MIRROR_FORCEDSPEC static void* xmirror_##_Type_##_constructor() \
+	{ \
+		Mirror::Enum<_Type_>::instance = &xmirror_##_Type_##_meta::instance; \
+		Mirror::Flags<_Type_>::instance = &xmirror_##_Type_##_meta::instance; \
+		return &Mirror::StaticInstance<Mirror::Executor<&xmirror_##_Type_##_constructor>>::instance;
+
+#define MIRROR_FLAGS_ENUM_EXTERNAL(_Type_, _Storage_, ...) \
+	struct xmirror_##_Type_##_meta \
+	{ \
+		struct Values { int64_t __VA_ARGS__; }; \
+		static inline _Storage_ Mirror::TFlags<_Type_, Values> instance = Mirror::TFlags<_Type_, Values>(#_Type_, #__VA_ARGS__); \
+	}; \
+	MIRROR_FORCEDSPEC static void* xmirror_##_Type_##_constructor() \
+	{ \
+		Mirror::Enum<_Type_>::instance = &xmirror_##_Type_##_meta::instance; \
+		Mirror::Flags<_Type_>::instance = &xmirror_##_Type_##_meta::instance; \
+		return &Mirror::StaticInstance<Mirror::Executor<&xmirror_##_Type_##_constructor>>::instance; \
+	}
+
 namespace Mirror
 {
 	using namespace std;
@@ -35,50 +66,59 @@ namespace Mirror
 	template<typename Type> requires is_enum_v<Type>
 	struct Enum
 	{
+		struct Pair
+		{
+			string_view name;
+			Type value;
+		};
+
 		string_view name;
-		vector<string> names;
+		vector<string_view> names; // views into the static text of the enum declaration
 		vector<Type> values;
-		unordered_map<string_view, Type> to_enum;
-		unordered_map<Type, string_view> to_string;
+		vector<Pair> pairs; // in declaration order
+		vector<Pair> sorted; // by value, for sparse enums
+		vector<string_view> dense; // name by value - first for enums without big gaps, empty for invalid values
+		uint64_t first = 0; // smallest value, differences are taken modulo 2^64 to work for any underlying type
+		NameTable<Pair> to_enum;
 
 		static inline Enum* instance;
 
 		// Convert value to string. Throws if value is invalid.
 		static string_view ToString(Type value)
 		{
-			auto str = instance->to_string.find(value);
-			if (str == instance->to_string.end())
+			string_view str = instance->Find(value);
+			if (str.empty())
 				throw logic_error(format("{} enum: invalid ToString conversion of ({})", instance->name, int(value)));
-			return str->second;
+			return str;
 		}
 
 		// Conver value to string. Doesn't throw.
 		static optional<string_view> GetString(Type value)
 		{
-			auto str = instance->to_string.find(value);
-			return (str != instance->to_string.end()) ? optional(str->second) : nullopt;
+			string_view str = instance->Find(value);
+			return !str.empty() ? optional(str) : nullopt;
 		}
 
 		// Get value by name. Throws if name is invalid
 		static Type ToValue(string_view name)
 		{
-			auto val = instance->to_enum.find(name);
-			if (val == instance->to_enum.end())
+			const Pair* pair = instance->to_enum.Find(name);
+			if (!pair)
 				throw logic_error(format("{} enum: invalid ToValue conversion of '{}'", instance->name, name));
-			return val->second;
+			return pair->value;
 		}
 
 		// Get value by name. Doesn't throw
 		static optional<Type> GetValue(string_view name)
 		{
-			auto val = instance->to_enum.find(name);
-			return (val != instance->to_enum.end()) ? optional(val->second) : nullopt;
+			const Pair* pair = instance->to_enum.Find(name);
+			return pair ? optional(pair->value) : nullopt;
 		}
 
 		// Check if name is valid
 		static bool IsValue(string_view name)
 		{
-			return instance->to_enum.contains(name);
+			return instance->to_enum.Find(name) != nullptr;
 		}
 
 		// Get name of the enum
@@ -96,14 +136,49 @@ namespace Mirror
 			return span(instance->values.begin(), instance->values.end());
 		}
 
-		// Get pairs of {name, value}
+		// Get pairs of {name, value} in declaration order
 		static auto GetPairs()
 		{
-			return views::all(instance->to_enum);
+			return span<const Pair>(instance->pairs);
 		}
 
 		// Get number of enum values
 		static int Num() { return instance->values.size(); }
+
+	protected:
+		// Name of a value, empty if the value is invalid. The first name wins for aliased values.
+		string_view Find(Type value) const
+		{
+			uint64_t index = uint64_t(value) - first;
+			if (!dense.empty())
+				return index < dense.size() ? dense[size_t(index)] : string_view();
+
+			auto it = ranges::lower_bound(sorted, value, {}, &Pair::value);
+			return it != sorted.end() && it->value == value ? it->name : string_view();
+		}
+
+		void Index()
+		{
+			for (size_t i = 0; i < names.size(); i++)
+				pairs.push_back({names[i], values[i]});
+			to_enum.Build(pairs | views::transform([](const Pair& pair){ return &pair; }));
+
+			sorted = pairs;
+			ranges::stable_sort(sorted, {}, &Pair::value);
+			auto [duplicates, end] = ranges::unique(sorted, {}, &Pair::value);
+			sorted.erase(duplicates, end);
+			if (sorted.empty()) return;
+
+			// direct indexing if at least half of the range is used
+			first = uint64_t(sorted.front().value);
+			uint64_t last = uint64_t(sorted.back().value) - first;
+			if (last >= sorted.size() * 2) return; // also skips the full 64-bit range, where last + 1 would overflow
+
+			dense.resize(size_t(last + 1));
+			for (const Pair& pair : sorted)
+				dense[size_t(uint64_t(pair.value) - first)] = pair.name;
+			sorted.clear();
+		}
 	};
 
 	template<typename Type, typename ValuesType>
@@ -125,7 +200,7 @@ namespace Mirror
 			for (int64_t value = 0, i = 0; i < num; i++)
 			{
 				if (vals[i] != inversed[i]) vals[i] = value;
-				value = vals[i] + 1;
+				value = int64_t(uint64_t(vals[i]) + 1); // unsigned to not overflow after the max value
 			}
 
 			for (size_t off = 0, next; off != string::npos;)
@@ -136,18 +211,136 @@ namespace Mirror
 				string_view ename(text.substr(off, next != string::npos ? next - off : string::npos));
 				off = text.find(',', next);
 
-				this->names.emplace_back(ename);
+				this->names.push_back(ename);
 			}
 
 			for (int i = 0; i < num; i++)
+				this->values.push_back(Type(vals[i]));
+
+			this->Index();
+			this->instance = this;
+		}
+	};
+}
+
+namespace Mirror
+{
+	using namespace std;
+
+	// Conversion of bit flag combinations. Enumerators with a single bit name the bits, others are used for exact matches.
+	template<typename Type> requires is_enum_v<Type>
+	struct Flags
+	{
+		string_view bits[64]; // name by bit position
+
+		static inline Flags* instance;
+
+		// Check if the enum was declared with FLAGS_ENUM
+		static bool IsFlags() { return instance != nullptr; }
+
+		// Call append(text) for the names and separators of value, an exact enumerator match is used as is.
+		// Throws if value has unnamed bits.
+		template<typename Append>
+		static void Format(Type value, Append&& append)
+		{
+			if (optional<string_view> name = Enum<Type>::GetString(value))
+				return append(*name);
+
+			bool first = true;
+			for (uint64_t bits = uint64_t(value); bits; bits &= bits - 1)
 			{
-				Type value = Type(vals[i]);
-				this->values.push_back(value);
-				this->to_enum.emplace(this->names[i], value);
-				this->to_string.emplace(value, this->names[i]);
+				string_view name = instance->bits[countr_zero(bits)];
+				if (name.empty())
+					throw logic_error(format("{} flags: invalid ToString conversion of ({})", Enum<Type>::GetName(), uint64_t(value)));
+
+				if (!first) append(string_view("|"));
+				append(name);
+				first = false;
 			}
+		}
 
-			this->instance = this;
+		// Format value into the buffer without allocations. Throws if the buffer is too small.
+		static string_view ToString(Type value, span<char> buffer)
+		{
+			size_t size = 0;
+			Format(value, [&](string_view text)
+			{
+				if (text.size() > buffer.size() - size)
+					throw logic_error(format("{} flags: buffer of {} chars is too small", Enum<Type>::GetName(), buffer.size()));
+				ranges::copy(text, buffer.data() + size);
+				size += text.size();
+			});
+			return string_view(buffer.data(), size);
+		}
+
+		// Format value into the buffer, or into fallback if it doesn't fit. Allocates only in the second case.
+		static string_view ToString(Type value, span<char> buffer, string& fallback)
+		{
+			size_t size = 0;
+			bool fits = true;
+			Format(value, [&](string_view text)
+			{
+				fits = fits && text.size() <= buffer.size() - size;
+				if (!fits) return;
+				ranges::copy(text, buffer.data() + size);
+				size += text.size();
+			});
+			if (fits) return string_view(buffer.data(), size);
+
+			fallback = ToString(value);
+			return fallback;
+		}
+
+		static string ToString(Type value)
+		{
+			string str;
+			Format(value, [&](string_view text){ str.append(text); });
+			return str;
+		}
+
+		// Parse names separated by '|', spaces around names are ignored. Throws if a name is invalid.
+		static Type ToValue(string_view text)
+		{
+			optional<Type> value = GetValue(text);
+			if (!value)
+				throw logic_error(format("{} flags: invalid ToValue conversion of '{}'", Enum<Type>::GetName(), text));
+			return *value;
+		}
+
+		// Parse names separated by '|'. An empty string is no flags, empty names between separators are invalid. Doesn't throw
+		static optional<Type> GetValue(string_view text)
+		{
+			if (text.find_first_not_of(' ') == string_view::npos) return Type(0);
+
+			uint64_t bits = 0;
+			for (size_t pos = 0; pos <= text.size();)
+			{
+				size_t end = min(text.find('|', pos), text.size());
+				string_view name = text.substr(pos, end - pos);
+				pos = end + 1;
+
+				size_t first = name.find_first_not_of(' ');
+				if (first == string_view::npos) return nullopt;
+				name = name.substr(first, name.find_last_not_of(' ') - first + 1);
+
+				optional<Type> value = Enum<Type>::GetValue(name);
+				if (!value) return nullopt;
+				bits |= uint64_t(*value);
+			}
+			return Type(bits);
+		}
+	};
+
+	template<typename Type, typename ValuesType>
+	struct TFlags : TEnum<Type, ValuesType>, Flags<Type>
+	{
+		TFlags(string_view name, string_view text) : TEnum<Type, ValuesType>(name, text)
+		{
+			for (auto [bit_name, value] : this->pairs)
+				if (has_single_bit(uint64_t(value)) && this->bits[countr_zero(uint64_t(value))].empty())
+					this->bits[countr_zero(uint64_t(value))] = bit_name;
+
+			Flags<Type>::instance = this;
 		}
 	};
 }
\ No newline at end of file
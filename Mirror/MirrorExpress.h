@@ -9,8 +9,11 @@
 #define STRUCT(_Type_, ...) MIRROR_STRUCT(_Type_, Mirror::Class, Mirror::Property, Mirror::Method,, __VA_ARGS__)
 #define ENUM(_Type_, ...) MIRROR_ENUM(_Type_,, __VA_ARGS__)
 #define XENUM(_Type_, ...) MIRROR_ENUM_EXTERNAL(_Type_,, __VA_ARGS__)
+#define FLAGS_ENUM(_Type_, ...) MIRROR_FLAGS_ENUM(_Type_,, __VA_ARGS__)
+#define XFLAGS_ENUM(_Type_, ...) MIRROR_FLAGS_ENUM_EXTERNAL(_Type_,, __VA_ARGS__)
 
 #define MULTIBASE(...) MIRROR_MULTIBASE(__VA_ARGS__)
+#define DIRTY_FLAGS(...) MIRROR_DIRTY_FLAGS(__VA_ARGS__)
 
 #define PROPERTY(name, ...) MIRROR_PROPERTY(name,, __VA_ARGS__)
 #define XPROPERTY(name, ...) decltype(name) MIRROR_PROPERTY_DATA(name,, __VA_ARGS__)
@@ -3,6 +3,10 @@
 #include <typeindex>
 #include <type_traits>
 #include <format>
+#include <stdexcept>
+#include <span>
+#include <array>
+#include <utility>
 
 #define MIRROR_METHOD_META(_Name_, _NativeName_, _Storage_, ...) \
 	xproperty_##_Name_##_type(); \
@@ -26,25 +30,70 @@ namespace Mirror
 {
 	using namespace std;
 
+	template<typename Signature>
+	class MethodHandle;
+
+	// Type information of a method argument or return value
+	struct Argument
+	{
+		const type_info* type = nullptr;
+		size_t size = 0; // storage size, references are stored as pointers
+		size_t alignment = 0;
+		bool reference = false;
+
+		template<typename Type>
+		static Argument Of()
+		{
+			if constexpr (is_void_v<Type>)
+				return {&typeid(void)};
+			else if constexpr (is_reference_v<Type>)
+				return {&typeid(Type), sizeof(void*), alignof(void*), true};
+			else
+				return {&typeid(Type), sizeof(Type), alignof(Type), false};
+		}
+	};
+
+	template<typename... Args>
+	struct ArgumentList
+	{
+		static inline const array<Argument, sizeof...(Args)> info = { Argument::Of<Args>()... };
+	};
+
 	class Method
 	{
 	protected:
 		struct Unknown;
 		using GenericFunc = void (Unknown::*)();
 		using InvokerFunc = void (*)();
+		using ThunkFunc = void (*)(void*, const GenericFunc*, void* const*, void*);
 
 		GenericFunc func;
 		InvokerFunc invoker;
+		ThunkFunc thunk;
 		void* (*caster)(void*) = nullptr;
 		Method* (*copy)(const Method*);
+		ptrdiff_t offset = 0; // scope offset if the scope is reached by a non-virtual cast
+		bool fixed = true;
 
 		friend class Class;
 
+		template<typename>
+		friend class MethodHandle;
+
+		// Move the offset into a heir class scope, null shift means the heir casts through a virtual base
+		void Rebase(const ptrdiff_t* shift)
+		{
+			if (shift) offset += *shift;
+			else fixed = false;
+		}
+
 	public:
 		string_view name;
 		const type_info* type;
 		type_index signature;
 		int num_args;
+		span<const Argument> arguments;
+		Argument result;
 
 		struct
 		{
@@ -62,6 +111,37 @@ namespace Mirror
 			return (scope->*method)(forward<Args>(args)...);
 		}
 
+		template<typename Return, typename Object, typename... Args>
+		static void Thunk(void* scope, const GenericFunc* func, void* const* args, void* result)
+		{
+			[&]<size_t... Indices>(index_sequence<Indices...>)
+			{
+				auto call = [&]() -> Return
+				{
+					return Invoker<Return, Object, Args...>((Object*)scope, func, static_cast<Args&&>(*(remove_reference_t<Args>*)args[Indices])...);
+				};
+
+				if constexpr (is_void_v<Return>)
+					call();
+				else if constexpr (is_reference_v<Return>)
+				{
+					Return value = call();
+					if (result) *(remove_reference_t<Return>**)result = &value;
+				}
+				else if (result)
+					new (result) Return(call());
+				else
+					call();
+			}
+			(index_sequence_for<Args...>());
+		}
+
+		void* Scope(void* ptr) const
+		{
+			if (fixed) return (char*)ptr + offset;
+			return caster ? caster(ptr) : ptr;
+		}
+
 		template<typename Return, typename... Args, typename... Types>
 		Return Invoke(Return (*)(Args ...), void* obj, Types&&... args) const
 		{
@@ -87,7 +167,10 @@ namespace Mirror
 			(decltype(method)&)func = method;
 			auto _invoker = &Method::Invoker<Return, Object, Args...>;
 			invoker = *(InvokerFunc*)&_invoker;
+			thunk = &Method::Thunk<Return, Object, Args...>;
 			num_args = sizeof...(Args);
+			arguments = ArgumentList<Args...>::info;
+			result = Argument::Of<Return>();
 		}
 
 		template<typename Signature, typename Object, typename... Args>
@@ -111,9 +194,81 @@ namespace Mirror
 			return caster ? caster(ptr) : ptr;
 		}
 
+		// Call with type-erased arguments, args holds a pointer to each argument value.
+		// Arguments taken by value or by rvalue reference are moved from.
+		// The return value is constructed in result storage of result.size bytes, a reference is stored as a pointer.
+		// Result may be null to discard the return value.
+		void Call(void* obj, span<void* const> args, void* result = nullptr) const
+		{
+			if (args.size() != arguments.size())
+				throw logic_error(format("Invalid number of arguments calling '{}' in '{}' ({}/{})", name, scope.name, args.size(), arguments.size()));
+			thunk(Scope(obj), &func, args.data(), result);
+		}
+
+		template<typename Type> requires (!is_pointer_v<Type>)
+		void Call(const Type& obj, span<void* const> args, void* result = nullptr) const
+		{
+			Call(obj.GetThis(), args, result);
+		}
+
+		// Bind to a signature. Throws if the signature doesn't match.
+		template<typename Signature>
+		MethodHandle<Signature> Bind() const { return MethodHandle<Signature>(*this); }
+
 		virtual ~Method() = default;
 	};
 
+	// Method bound to a signature checked once at bind time.
+	// A call is a single indirect call with perfectly forwarded arguments.
+	template<typename Return, typename... Args>
+	class MethodHandle<Return (Args ...)>
+	{
+		using InvokerFunc = Return (*)(void*, const Method::GenericFunc*, Args&&...);
+
+		InvokerFunc invoker = nullptr;
+		Method::GenericFunc func;
+		void* (*caster)(void*) = nullptr;
+		ptrdiff_t offset = 0;
+
+		template<typename Arg, typename Type>
+		static decltype(auto) Forward(Type&& value)
+		{
+			if constexpr (is_reference_v<Arg> || (is_same_v<remove_cvref_t<Type>, Arg> && is_rvalue_reference_v<Type&&>))
+				return forward<Type>(value);
+			else
+				return Arg(forward<Type>(value)); // by value parameter gets its own copy
+		}
+
+	public:
+		MethodHandle() = default;
+
+		explicit MethodHandle(const Method& method) : func(method.func)
+		{
+			if (method.signature != typeid(Return (Args ...)))
+				throw logic_error(format("Signature mismatch binding '{}' in '{}'", method.name, method.scope.name));
+
+			invoker = *(InvokerFunc*)&method.invoker;
+			if (method.fixed) offset = method.offset;
+			else caster = method.caster;
+		}
+
+		explicit operator bool() const { return invoker != nullptr; }
+
+		template<typename... Types>
+		Return operator()(void* obj, Types&&... args) const
+		{
+			static_assert(sizeof...(Types) == sizeof...(Args), "Invalid number of arguments");
+			obj = caster ? caster(obj) : (char*)obj + offset;
+			return invoker(obj, &func, Forward<Args>(forward<Types>(args))...);
+		}
+
+		template<typename Type, typename... Types> requires (!is_pointer_v<Type>)
+		Return operator()(const Type& obj, Types&&... args) const
+		{
+			return (*this)(obj.GetThis(), forward<Types>(args)...);
+		}
+	};
+
 	template<typename... Types>
 	struct CombineMethods : Types...
 	{
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <shared_mutex>
+#include <algorithm>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "MirrorProperty.h"
+
+namespace Mirror
+{
+	using namespace std;
+
+	// Immutable accessor for a value in nested structures and containers.
+	// Consecutive plain properties are folded into a single offset.
+	class PropertyPath
+	{
+		struct Step
+		{
+			ptrdiff_t offset = 0;
+			const Property* property = nullptr; // step through the property pointer
+			const Container* container = nullptr; // or step into a container element
+			size_t index = 0;
+			shared_ptr<const void> key; // parsed map key
+		};
+
+		vector<Step> steps;
+		ptrdiff_t offset = 0;
+		const Property* target = nullptr;
+		const type_info* type = nullptr;
+
+	public:
+		PropertyPath() = default;
+
+		// Compile from a range of properties as returned by Class::Resolve
+		template<PropertyRange Path>
+		explicit PropertyPath(const Path& path)
+		{
+			for (const Property* property : path)
+				Append(property);
+		}
+
+		// Extend the path with a property of the current value
+		void Append(const Property* property)
+		{
+			Flush();
+			target = property;
+			type = property->type;
+		}
+
+		// Extend the path with an element of the current container value by position
+		void Append(const Container* container, size_t index)
+		{
+			Flush();
+			steps.push_back({offset, nullptr, container, index, nullptr});
+			offset = 0;
+			type = container->value_type;
+		}
+
+		// Extend the path with a mapped value of the current map value by key text.
+		// The key is parsed once here, false if the text isn't a valid key of the map.
+		bool Append(const Container* container, string_view key)
+		{
+			shared_ptr<const void> parsed = container->parse_key(key);
+			if (!parsed) return false;
+
+			Flush();
+			steps.push_back({offset, nullptr, container, 0, move(parsed)});
+			offset = 0;
+			type = container->value_type;
+			return true;
+		}
+
+		// Property at the end of the path, null if the path ends with a container element
+		const Property* Target() const { return target; }
+
+		// Type of the value at the end of the path
+		const type_info* GetType() const { return type; }
+
+		bool Empty() const { return !type; }
+
+		explicit operator bool() const { return type != nullptr; }
+
+		// Find pointer to the structure holding the target property or to the target element.
+		// Returns null if a container element is missing.
+		void* GetScope(void* ptr) const
+		{
+			for (const Step& step : steps)
+			{
+				ptr = (char*)ptr + step.offset;
+				if (step.property)
+					ptr = step.property->GetPointer(ptr);
+				else if (step.container->IsMap())
+					ptr = step.container->find(ptr, step.key.get());
+				else
+					ptr = step.container->at(ptr, step.index);
+
+				if (!ptr) return nullptr;
+			}
+			return (char*)ptr + offset;
+		}
+
+		// Pointer to the value at the end of the path or null if a container element is missing
+		void* GetPointer(void* ptr) const
+		{
+			ptr = GetScope(ptr);
+			return (ptr && target) ? target->GetPointer(ptr) : ptr;
+		}
+
+		template<typename ValueType, Mirrored Type>
+		ValueType& GetValue(const Type& obj) const
+		{
+			return GetValue<ValueType>(obj.GetThis());
+		}
+
+		template<typename ValueType>
+		ValueType& GetValue(void* ptr) const
+		{
+			void* scope = Find(ptr);
+			if (target) return target->GetValue<ValueType>(scope);
+			assert(type_index(*type) == typeid(ValueType));
+			return *(ValueType*)scope;
+		}
+
+		template<typename ValueType, Mirrored Type>
+		void SetValue(Type& obj, ValueType&& value) const
+		{
+			SetValue(obj.GetThis(), forward<ValueType>(value));
+		}
+
+		template<typename ValueType>
+		void SetValue(void* ptr, ValueType&& value) const
+		{
+			void* scope = Find(ptr);
+			if (target) return target->SetValue(scope, forward<ValueType>(value));
+			assert(type_index(*type) == typeid(ValueType));
+			*(remove_cvref_t<ValueType>*)scope = forward<ValueType>(value);
+		}
+
+	private:
+		void Flush()
+		{
+			if (!target) return;
+
+			if (target->plain)
+				offset += target->offset;
+			else
+			{
+				steps.push_back({offset, target, nullptr, 0, nullptr});
+				offset = 0;
+			}
+			target = nullptr;
+		}
+
+		void* Find(void* ptr) const
+		{
+			ptr = GetScope(ptr);
+			if (!ptr) throw logic_error("Property path refers to a missing container element");
+			return ptr;
+		}
+	};
+
+	// Thread safe LRU cache of compiled paths keyed by the path string.
+	// Hits share the lock and only stamp the entry, the exclusive lock is taken to insert and evict the least recently used.
+	class PathCache
+	{
+		struct Entry
+		{
+			string path;
+			shared_ptr<const PropertyPath> compiled;
+			atomic<size_t> used;
+		};
+
+		list<Entry> entries;
+		unordered_map<string_view, list<Entry>::iterator> index;
+		size_t capacity;
+		atomic<size_t> clock = 0;
+		shared_mutex guard;
+
+	public:
+		explicit PathCache(size_t capacity = 64) : capacity(capacity) {}
+
+		// Get cached path or compile it with compile(path). Unresolved paths are not cached and return null.
+		template<typename Compile>
+		shared_ptr<const PropertyPath> Get(string_view path, Compile&& compile)
+		{
+			{
+				shared_lock lock(guard);
+				auto found = index.find(path);
+				if (found != index.end())
+				{
+					found->second->used.store(++clock, memory_order_relaxed);
+					return found->second->compiled;
+				}
+			}
+
+			PropertyPath compiled = compile(path);
+			if (!compiled) return nullptr;
+
+			unique_lock lock(guard);
+			auto found = index.find(path);
+			if (found != index.end()) return found->second->compiled; // compiled by another thread meanwhile
+
+			if (entries.size() >= capacity && !entries.empty())
+			{
+				auto oldest = ranges::min_element(entries, {}, [](const Entry& entry) { return entry.used.load(memory_order_relaxed); });
+				index.erase(oldest->path);
+				entries.erase(oldest);
+			}
+
+			Entry& entry = entries.emplace_front(string(path), make_shared<const PropertyPath>(move(compiled)), ++clock);
+			index.emplace(entry.path, entries.begin());
+			return entry.compiled;
+		}
+
+		void Clear()
+		{
+			unique_lock lock(guard);
+			index.clear();
+			entries.clear();
+		}
+	};
+}
\ No newline at end of file
@@ -4,8 +4,11 @@
 #include <typeindex>
 #include <cassert>
 #include <any>
+#include <format>
+#include <stdexcept>
 
 #include "MirrorTools.h"
+#include "MirrorContainer.h"
 
 #define MIRROR_PROPERTY(_Property_, _Storage_, ...) \
 	MIRROR_PROPERTY_DATA(_Property_, _Storage_, __VA_ARGS__); \
@@ -24,6 +27,7 @@
 			static void Set(void* obj, void* value) { ((ClassType*)obj)->_Property_ = *(Type*)value; } \
 			static void Move(void* obj, void* value) { ((ClassType*)obj)->_Property_ = std::move(*(Type*)value); } \
 			static void* Pointer(void* obj) { return &((ClassType*)obj)->_Property_; } \
+			static void Copy(void* obj, void* storage) { new (storage) Type(((ClassType*)obj)->_Property_); } \
 		}; \
 		struct Access : BasicAccess<Meta::Type> { __VA_ARGS__ }; \
 		static std::string_view Name() { using namespace std::literals; return #_Property_##sv; } \
@@ -31,6 +35,7 @@
 			+[]{ Meta::Construct()->AddProperty(new Meta::PropertyType((xproperty_##_Property_##_meta*)nullptr)); }; \
 	}; \
 	static MIRROR_FORCEDSPEC auto xmirror_##_Property_##_register() { return &xproperty_##_Property_##_meta::constructor; } \
+	friend xproperty_##_Property_##_meta* xmirror_property(Mirror::NameTag<#_Property_>, Meta::Type*) { return nullptr; } \
 	friend struct xproperty_##_Property_##_meta
 
 #define MIRROR_VIRTUAL_PROPERTY(_Property_, _Storage_, ...) \
@@ -45,13 +50,15 @@
 			+[]{ Meta::Construct()->AddProperty(new Meta::PropertyType((xproperty_##_Property_##_meta*)nullptr)); }; \
 	}; \
 	static MIRROR_FORCEDSPEC auto xmirror_##_Property_##_register() { return &xproperty_##_Property_##_meta::constructor; } \
+	friend xproperty_##_Property_##_meta* xmirror_property(Mirror::NameTag<#_Property_>, Meta::Type*) { return nullptr; }
 
 #define MIRROR_GETTER(getter) \
 	static void* Get(void* ptr) { return Gett((Meta::Type*)ptr, &Meta::Type::getter); } \
 	template<typename Type> \
 	static void* Gett(Type* ptr, ...) { return (void*)&ptr->getter(); } \
 	static void* Gett(Meta::Type* ptr, Type (Meta::Type::*)() const) { return Mirror::Temporal::Make<Type>(ptr->getter()); } \
-	static void* Gett(Meta::Type* ptr, Type (Meta::Type::*)()) { return Mirror::Temporal::Make<Type>(ptr->getter()); }
+	static void* Gett(Meta::Type* ptr, Type (Meta::Type::*)()) { return Mirror::Temporal::Make<Type>(ptr->getter()); } \
+	static void Copy(void* ptr, void* storage) { new (storage) Type(((Meta::Type*)ptr)->getter()); }
 
 #define MIRROR_SETTER(setter) \
 	static void Set(void* domain, void* value) { ((Meta::Type*)domain)->setter(*(Type*)value); } \
@@ -67,6 +74,9 @@ namespace Mirror
 {
 	using namespace std;
 
+	template<typename Type>
+	struct Comparator;
+
 	class Property
 	{
 	protected:
@@ -76,19 +86,49 @@ namespace Mirror
 
 		friend class Class;
 
+		// Set index in the class property list and the offset of the object dirty flags, null if not tracked
+		void Track(size_t position, const ptrdiff_t* flags)
+		{
+			index = uint32_t(position);
+			tracked = flags != nullptr;
+			dirty = flags ? *flags : 0;
+		}
+
+		// Move the offset into a heir class scope, null shift means the heir casts through a virtual base
+		void Rebase(const ptrdiff_t* shift)
+		{
+			if (shift) offset += *shift;
+			else plain = false;
+		}
+
 	public:
 		void* (*getter)(void*) = nullptr;
 		void (*setter)(void*, void*) = nullptr;
 		void (*mover)(void*, void*) = nullptr;
 		void* (*pointer)(void*) = nullptr;
+		void (*copier)(void*, void*) = nullptr; // copy-construct value into provided storage
+		void (*destructor)(void*) = nullptr;
+		bool (*equal)(const void*, const void*) = nullptr; // null if values can't be compared
+		int (*compare)(const void*, const void*) = nullptr; // null if values have no ordering
+		size_t (*hash)(const void*) = nullptr;
 		any (*getany)(void*) = nullptr;
 
 		string_view name;
 		const type_info* type;
 		size_t size;
+		size_t alignment;
+		ptrdiff_t offset = 0; // byte offset from the object, valid for plain properties
+		uint32_t index = 0; // position in the class property list
+		ptrdiff_t dirty = 0; // byte offset of the object dirty flags, valid for tracked properties
+		bool tracked = false;
+		bool plain = false; // data member with direct access reachable by a constant offset
+		bool inplace = false; // data member without a custom setter or mover, can be written through its pointer
 		Class* ref_class = nullptr;
+		const Container* container = nullptr; // container access if the type is an stl container
 		type_index type_id;
 		bool copy_constructible, copy_assignable;
+		bool trivially_copyable;
+		bool unique_representation; // equal values have equal bytes, reflected types are compared by their properties
 		string_view meta_text;
 
 		struct
@@ -111,10 +151,13 @@ namespace Mirror
 			name = meta->Name();
 			type = &typeid(Type);
 			size = sizeof(Type);
+			alignment = alignof(Type);
 
 			if constexpr (Mirrored<Type>)
 				ref_class = Type::Meta::GetClass();
 
+			container = GetContainer<Type>();
+
 			if constexpr (requires{ getter = &Access::Get; })
 				getter = &Access::Get;
 
@@ -127,6 +170,34 @@ namespace Mirror
 			if constexpr (requires{ pointer = &Access::Pointer; })
 				pointer = &Access::Pointer;
 
+			if constexpr (CopyConstructible<Type> && requires{ copier = &Access::Copy; })
+				copier = &Access::Copy;
+
+			destructor = [](void* ptr){ ((Type*)ptr)->~Type(); };
+
+			using Compare = Comparator<Type>;
+			if constexpr (Compare::can_equal)
+				equal = [](const void* a, const void* b){ return Compare::Equal(*(const Type*)a, *(const Type*)b); };
+
+			if constexpr (Compare::can_compare)
+				compare = [](const void* a, const void* b){ return Compare::Compare(*(const Type*)a, *(const Type*)b); };
+
+			if constexpr (Compare::can_hash)
+				hash = [](const void* ptr){ return Compare::Hash(*(const Type*)ptr); };
+
+			if constexpr (requires { typename PropertyMeta::template BasicAccess<typename PropertyMeta::Scope>; })
+			{
+				using Basic = typename PropertyMeta::template BasicAccess<typename PropertyMeta::Scope>;
+
+				inplace = pointer == &Basic::Pointer;
+				if constexpr (CopyAssignable<Type>) inplace = inplace && setter == &Basic::Set;
+				if constexpr (is_move_assignable_v<Type>) inplace = inplace && mover == &Basic::Move;
+				plain = inplace && getter == &Basic::Get;
+
+				char* object = (char*)FakeObject();
+				offset = (char*)Basic::Pointer(object) - object;
+			}
+
 			if constexpr (CopyConstructible<Type>)
 				getany = [](void* ptr){ return make_any<Type>(*(Type*)ptr); };
 
@@ -138,6 +209,8 @@ namespace Mirror
 
 			copy_constructible = CopyConstructible<Type>;
 			copy_assignable = CopyAssignable<Type>;
+			trivially_copyable = is_trivially_copyable_v<Type>;
+			unique_representation = has_unique_object_representations_v<Type> && !Mirrored<Type>;
 		}
 
 		template<typename ValueType, typename Type>
@@ -150,6 +223,7 @@ namespace Mirror
 		ValueType& GetValue(void* ptr) const
 		{
 			assert(type_index(*type) == typeid(ValueType));
+			if (plain) return *(ValueType*)((char*)ptr + offset);
 			if (caster) ptr = caster(ptr);
 			return *(ValueType*)getter(ptr);
 		}
@@ -162,10 +236,26 @@ namespace Mirror
 
 		void* GetPointer(void* ptr) const
 		{
+			if (plain) return (char*)ptr + offset;
 			if (caster) ptr = caster(ptr);
 			return pointer(ptr);
 		}
 
+		// Storage of the value for deserializing in place, reusing its capacity. Null if a setter has to be called.
+		// The property is marked dirty.
+		void* GetStorage(void* ptr) const
+		{
+			if (!inplace) return nullptr;
+			MarkDirty(ptr);
+			return GetPointer(ptr);
+		}
+
+		template<Mirrored Type>
+		void* GetStorage(Type& obj) const
+		{
+			return GetStorage(obj.GetThis());
+		}
+
 		template<typename ValueType, Mirrored Type>
 		void SetValue(Type& obj, ValueType&& value) const
 		{
@@ -176,6 +266,18 @@ namespace Mirror
 		void SetValue(void* ptr, ValueType&& value) const
 		{
 			assert(type_index(*type) == typeid(ValueType));
+			MarkDirty(ptr);
+
+			using Type = remove_cvref_t<ValueType>;
+			if constexpr (is_assignable_v<Type&, ValueType&&>)
+			{
+				if (plain)
+				{
+					*(Type*)((char*)ptr + offset) = forward<ValueType>(value);
+					return;
+				}
+			}
+
 			if (caster) ptr = caster(ptr);
 			if constexpr (is_rvalue_reference_v<ValueType&&>)
 				mover(ptr, &value);
@@ -183,25 +285,131 @@ namespace Mirror
 				setter(ptr, &value);
 		}
 
+		// Flag the property as written in an object of a class with dirty flags
+		void MarkDirty(void* ptr) const
+		{
+			if (tracked) ((uint64_t*)((char*)ptr + dirty))[index / 64] |= 1ull << (index % 64);
+		}
+
+		template<Mirrored Type>
+		void MarkDirty(Type& obj) const
+		{
+			MarkDirty(obj.GetThis());
+		}
+
+		// Copy value into caller storage of at least 'size' bytes aligned to 'alignment'. The caller destroys the copy.
+		// Getters returning by value construct the result directly in the storage.
+		void CopyTo(void* ptr, void* storage) const
+		{
+			if (caster) ptr = caster(ptr);
+			copier(ptr, storage);
+		}
+
+		// Copy value into the inline storage replacing its previous value
+		template<size_t Capacity>
+		void* CopyValue(void* ptr, ValueStorage<Capacity>& storage) const
+		{
+			void* memory = storage.Allocate(size, alignment, type, destructor);
+			CopyTo(ptr, memory);
+			storage.Commit(memory);
+			return memory;
+		}
+
+		template<size_t Capacity, Mirrored Type>
+		void* CopyValue(const Type& obj, ValueStorage<Capacity>& storage) const
+		{
+			return CopyValue(obj.GetThis(), storage);
+		}
+
+		// Copy value into a variable
+		template<typename ValueType>
+		void CopyValue(void* ptr, ValueType& value) const
+		{
+			assert(type_index(*type) == typeid(ValueType));
+			if (plain)
+			{
+				value = *(ValueType*)((char*)ptr + offset);
+				return;
+			}
+
+			alignas(ValueType) char storage[sizeof(ValueType)];
+			CopyTo(ptr, storage);
+			value = std::move(*(ValueType*)storage);
+			((ValueType*)storage)->~ValueType();
+		}
+
+		template<typename ValueType, Mirrored Type>
+		void CopyValue(const Type& obj, ValueType& value) const
+		{
+			CopyValue(obj.GetThis(), value);
+		}
+
+		// Borrow the value without a copy. Empty if the property has no pointer access.
+		ValueRef GetRef(void* ptr) const
+		{
+			if (!plain && !pointer) return {};
+			return {GetPointer(ptr), type};
+		}
+
+		template<Mirrored Type>
+		ValueRef GetRef(const Type& obj) const
+		{
+			return GetRef(obj.GetThis());
+		}
+
+		// Copy assign the referenced value. Throws if the types don't match.
+		void SetRef(void* ptr, ValueRef value) const
+		{
+			if (!value.type || *value.type != *type)
+				throw logic_error(format("Property '{}' of type '{}' can not be set from '{}'", name, type->name(), value.type ? value.type->name() : "null"));
+			MarkDirty(ptr);
+			if (caster) ptr = caster(ptr);
+			setter(ptr, value.ptr);
+		}
+
+		template<Mirrored Type>
+		void SetRef(Type& obj, ValueRef value) const
+		{
+			SetRef(obj.GetThis(), value);
+		}
+
+		// Move assign the referenced value leaving the source in a moved-from state. Throws if the types don't match.
+		void MoveRef(void* ptr, ValueRef value) const
+		{
+			if (!value.type || *value.type != *type)
+				throw logic_error(format("Property '{}' of type '{}' can not be set from '{}'", name, type->name(), value.type ? value.type->name() : "null"));
+			MarkDirty(ptr);
+			if (caster) ptr = caster(ptr);
+			mover(ptr, value.ptr);
+		}
+
+		template<Mirrored Type>
+		void MoveRef(Type& obj, ValueRef value) const
+		{
+			MoveRef(obj.GetThis(), value);
+		}
+
 		template<typename Type>
 		any GetAny(const Type& obj) const { return getany(GetPointer(obj.GetThis())); }
 
 		template<typename Type>
-		void SetAny(Type& obj, const any& value) { setter(GetScope(obj), castany(value)); }
+		void SetAny(Type& obj, const any& value) const { SetAny(obj.GetThis(), value); }
 
 		template<typename Type>
-		void SetAny(Type& obj, any&& value) { mover(GetScope(obj), castany(value)); }
+		void SetAny(Type& obj, any&& value) const { SetAny(obj.GetThis(), std::move(value)); }
 
 		any GetAny(void* ptr) const { return getany(GetPointer(ptr)); }
 
-		void SetAny(void* ptr, const any& value)
+		void SetAny(void* ptr, const any& value) const
 		{
+			MarkDirty(ptr);
 			if (caster) ptr = caster(ptr);
 			setter(ptr, castany(value));
 		}
 
-		void SetAny(void* obj, any&& value)
+		void SetAny(void* obj, any&& value) const
 		{
+			MarkDirty(obj);
 			if (caster) obj = caster(obj);
 			mover(obj, castany(value));
 		}
@@ -213,6 +421,11 @@ namespace Mirror
 			return caster ? caster(ptr) : ptr;
 		}
 
+		void* GetScope(void* ptr) const
+		{
+			return caster ? caster(ptr) : ptr;
+		}
+
 		virtual ~Property() = default;
 	};
 
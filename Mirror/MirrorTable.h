@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+namespace Mirror
+{
+	using namespace std;
+
+	// Read-only name lookup table built with a minimal perfect hash.
+	// Items are accessed through pointers and must expose a 'name' string_view.
+	// A lookup hashes the key once, reads one displacement and one entry, and never allocates.
+	template<typename Type>
+	class NameTable
+	{
+		struct alignas(32) Entry
+		{
+			uint32_t length = 0;
+			char prefix[20] = {};
+			const Type* item = nullptr;
+		};
+
+		vector<Entry> entries;
+		vector<uint32_t> displacements;
+		uint64_t seed = 0;
+
+	public:
+		// Rebuild the table from a range of item pointers. Later items win over earlier ones with the same name.
+		template<typename Range>
+		void Build(const Range& items)
+		{
+			vector<const Type*> unique;
+			unordered_map<string_view, size_t> positions;
+			for (const Type* item : items)
+			{
+				auto [position, inserted] = positions.try_emplace(item->name, unique.size());
+				if (inserted) unique.push_back(item);
+				else unique[position->second] = item;
+			}
+
+			entries.assign(unique.size(), Entry());
+			if (unique.empty())
+			{
+				displacements.clear();
+				return;
+			}
+
+			size_t buckets = (unique.size() + 3) / 4;
+			for (seed = 0; !Place(unique, buckets); ++seed)
+				if (seed % 8 == 7) buckets = min(unique.size(), buckets * 2);
+		}
+
+		// Find item by name or return null
+		const Type* Find(string_view key) const
+		{
+			if (entries.empty()) return nullptr;
+
+			uint64_t hash = Hash(key, seed);
+			const Entry& entry = entries[Slot(hash, displacements[Bucket(hash, displacements.size())], entries.size())];
+
+			constexpr size_t inline_size = sizeof(entry.prefix);
+			if (entry.length != key.size() || memcmp(entry.prefix, key.data(), min(key.size(), inline_size)) != 0)
+				return nullptr;
+
+			if (key.size() > inline_size && entry.item->name.substr(inline_size) != key.substr(inline_size))
+				return nullptr;
+
+			return entry.item;
+		}
+
+		// Number of unique names in the table
+		size_t Size() const { return entries.size(); }
+
+		bool Empty() const { return entries.empty(); }
+
+		static uint64_t Hash(string_view key, uint64_t seed)
+		{
+			const char* data = key.data();
+			size_t size = key.size();
+			uint64_t hash = (seed + size) * 0x9e3779b97f4a7c15ull;
+
+			if (size >= 8)
+			{
+				for (; size > 8; data += 8, size -= 8)
+					hash = Mix(hash ^ Load<uint64_t>(data));
+				hash = Mix(hash ^ Load<uint64_t>(data + size - 8));
+			}
+			else if (size >= 4)
+				hash = Mix(hash ^ (uint64_t(Load<uint32_t>(data)) << 32 | Load<uint32_t>(data + size - 4)));
+			else if (size)
+				hash = Mix(hash ^ (uint64_t(uint8_t(data[0])) << 16 | uint64_t(uint8_t(data[size / 2])) << 8 | uint8_t(data[size - 1])));
+
+			return hash ^ (hash >> 29);
+		}
+
+	private:
+		template<typename Word>
+		static Word Load(const char* data)
+		{
+			Word word;
+			memcpy(&word, data, sizeof(Word));
+			return word;
+		}
+
+		static uint64_t Mix(uint64_t value)
+		{
+			value *= 0xbf58476d1ce4e5b9ull;
+			return value ^ (value >> 31);
+		}
+
+		static size_t Bucket(uint64_t hash, size_t num)
+		{
+			return size_t((uint64_t(uint32_t(hash >> 32)) * num) >> 32);
+		}
+
+		static size_t Slot(uint64_t hash, uint32_t displacement, size_t num)
+		{
+			uint32_t mixed = uint32_t(hash) + displacement * (uint32_t(hash >> 32) | 1);
+			return size_t((uint64_t(mixed) * num) >> 32);
+		}
+
+		bool Place(const vector<const Type*>& items, size_t num_buckets)
+		{
+			size_t num = items.size();
+			vector<vector<pair<uint64_t, const Type*>>> buckets(num_buckets);
+			for (const Type* item : items)
+			{
+				uint64_t hash = Hash(item->name, seed);
+				buckets[Bucket(hash, num_buckets)].emplace_back(hash, item);
+			}
+
+			vector<size_t> order(num_buckets);
+			for (size_t i = 0; i < num_buckets; i++) order[i] = i;
+			ranges::stable_sort(order, [&](size_t a, size_t b){ return buckets[a].size() > buckets[b].size(); });
+
+			displacements.assign(num_buckets, 0);
+			vector<bool> taken(num);
+			vector<size_t> slots;
+
+			for (size_t b : order)
+			{
+				auto& bucket = buckets[b];
+				if (bucket.empty()) break;
+
+				bool placed = false;
+				for (uint32_t displacement = 0; !placed && displacement < num * 8; displacement++)
+				{
+					slots.clear();
+					for (auto& [hash, item] : bucket)
+					{
+						size_t slot = Slot(hash, displacement, num);
+						if (taken[slot] || ranges::find(slots, slot) != slots.end()) break;
+						slots.push_back(slot);
+					}
+
+					if (slots.size() != bucket.size()) continue;
+
+					for (size_t i = 0; i < slots.size(); i++)
+					{
+						const Type* item = bucket[i].second;
+						Entry& entry = entries[slots[i]];
+						entry.length = uint32_t(item->name.size());
+						memcpy(entry.prefix, item->name.data(), min(item->name.size(), sizeof(entry.prefix)));
+						entry.item = item;
+						taken[slots[i]] = true;
+					}
+
+					displacements[b] = displacement;
+					placed = true;
+				}
+
+				if (!placed) return false;
+			}
+
+			return true;
+		}
+	};
+}
\ No newline at end of file
@@ -1,6 +1,13 @@
 #pragma once
 
 #include <type_traits>
+#include <string_view>
+#include <cstdint>
+#include <cassert>
+#include <optional>
+#include <new>
+#include <typeinfo>
+#include <cstddef>
 
 namespace Mirror
 {
@@ -41,7 +48,7 @@ namespace Mirror
 	constexpr bool StlSet = StlContainer<Type> && is_same_v<typename Type::key_type, typename Type::value_type>;
 
 	template<typename Type>
-	concept StlMap = StlContainer<Type> && requires { Type::mapped_type; };
+	concept StlMap = StlContainer<Type> && requires { typename Type::mapped_type; };
 
 	template<typename Type>
 	concept CopyAssignable = 
@@ -60,26 +67,141 @@ namespace Mirror
 
 	template<typename...> struct TypeList;
 
-	class Temporal
+	// Suitably aligned non-null address to compute member and base offsets without an object
+	inline void* FakeObject() { return (void*)uintptr_t(0x1000); }
+
+	// String literal usable as a template argument
+	template<size_t Size>
+	struct StringLiteral
 	{
-		void* ptr;
-		void (*destructor)(void*);
+		char text[Size] = {};
+
+		constexpr StringLiteral() = default;
+		constexpr StringLiteral(const char (&str)[Size]) { for (size_t i = 0; i < Size; i++) text[i] = str[i]; }
+
+		constexpr size_t Length() const { return Size - 1; }
+		constexpr string_view View() const { return string_view(text, Size - 1); }
+		constexpr size_t Find(char c) const
+		{
+			for (size_t i = 0; i + 1 < Size; i++)
+				if (text[i] == c) return i;
+			return string_view::npos;
+		}
+
+		template<size_t Pos, size_t Len>
+		constexpr StringLiteral<Len + 1> Substr() const
+		{
+			StringLiteral<Len + 1> result;
+			for (size_t i = 0; i < Len; i++) result.text[i] = text[Pos + i];
+			return result;
+		}
+	};
+
+	// Tag type to select a property meta by name with overload resolution
+	template<StringLiteral Name>
+	struct NameTag {};
 
+	// Per thread holder of values returned by value from property getters. Overwritten by the next read of the same type.
+	class Temporal
+	{
 	public:
 		template<typename Type>
-		static void Destroy(void* ptr) { delete (Type*)ptr; }
+		static void* Make(Type&& value)
+		{
+			static thread_local optional<Type> copy;
+			copy.emplace(std::move(value));
+			return &*copy;
+		}
+	};
+
+	// Borrowed reference to a value of a known type. Doesn't own or copy the value.
+	struct ValueRef
+	{
+		void* ptr = nullptr;
+		const type_info* type = nullptr;
+
+		ValueRef() = default;
+		ValueRef(void* ptr, const type_info* type) : ptr(ptr), type(type) {}
+
+		template<typename Type> requires (!is_same_v<remove_cv_t<Type>, ValueRef>)
+		ValueRef(Type& value) : ptr((void*)&value), type(&typeid(Type)) {}
+
+		template<typename Type>
+		bool Is() const { return type && *type == typeid(Type); }
+
+		template<typename Type>
+		Type& Get() const
+		{
+			assert(Is<Type>());
+			return *(Type*)ptr;
+		}
+
+		// Pointer to the value or null if the type doesn't match
+		template<typename Type>
+		Type* TryGet() const { return Is<Type>() ? (Type*)ptr : nullptr; }
+
+		explicit operator bool() const { return ptr != nullptr; }
+	};
+
+	// Inline storage for a copy of a property value. Values larger than Capacity are placed on the heap.
+	template<size_t Capacity = 64>
+	class ValueStorage
+	{
+		alignas(max_align_t) char buffer[Capacity];
+		void* value = nullptr;
+		void* pending = nullptr; // heap memory returned by Allocate and not committed yet
+		void (*destructor)(void*) = nullptr;
+		const type_info* type = nullptr;
+		size_t alignment = 0;
+
+	public:
+		ValueStorage() = default;
+		ValueStorage(const ValueStorage&) = delete;
+		ValueStorage& operator=(const ValueStorage&) = delete;
+		~ValueStorage() { Reset(); }
+
+		// Destroy the stored value
+		void Reset()
+		{
+			if (pending) ::operator delete(pending, align_val_t(alignment));
+			pending = nullptr;
+
+			if (!value) return;
+			destructor(value);
+			if (value != buffer) ::operator delete(value, align_val_t(alignment));
+			value = nullptr;
+		}
+
+		// Release the current value and get uninitialized memory for a new one.
+		// The storage owns the memory until Commit, so it isn't leaked if constructing the value throws.
+		void* Allocate(size_t size, size_t align, const type_info* value_type, void (*value_destructor)(void*))
+		{
+			Reset();
+			alignment = align;
+			void* memory = (size <= Capacity && align <= alignof(max_align_t)) ? buffer : (pending = ::operator new(size, align_val_t(align)));
+			type = value_type;
+			destructor = value_destructor;
+			return memory;
+		}
+
+		// Mark memory returned by Allocate as holding a constructed value
+		void Commit(void* memory)
+		{
+			value = memory;
+			pending = nullptr;
+		}
 
 		template<typename Type>
-		static void* Make(const Type& original)
+		Type& Get() const
 		{
-			static thread_local Temporal copy;
-			if (copy.ptr) copy.destructor(copy.ptr);
-			copy.ptr = new Type(original);
-			copy.destructor = Destroy<Type>;
-			return copy.ptr;
+			assert(value && *type == typeid(Type));
+			return *(Type*)value;
 		}
 
-		~Temporal() { if (ptr) destructor(ptr); }
+		void* GetPointer() const { return value; }
+		const type_info* GetType() const { return type; }
+		ValueRef GetRef() const { return {value, type}; }
+		bool Empty() const { return value == nullptr; }
 	};
 
 	template<typename ReturnType, typename Type, typename... Arguments>
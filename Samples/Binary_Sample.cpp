@@ -0,0 +1,90 @@
+// This is an example of binary serialization\deserialization with the BinaryArchive addon
+// Archives are compact and fast to load with the same class schema, and are read property by property after the schema changes
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <map>
+
+#include "MirrorExpress.h"
+#include "BinaryArchive.hpp"
+
+using namespace std;
+using namespace Mirror;
+
+enum class StarType { ENUM(StarType, YellowDwarf, RedDwarf, RedGiant, RedSuperGiant, BlueGiant, WhiteDwarf, BrownDwarf) };
+
+struct Orbit
+{
+	BINARY_STRUCT(Orbit)
+	double PROPERTY(semi_major_axis) = 0; // adjacent plain fields are stored with a single memcpy
+	double PROPERTY(eccentricity) = 0;
+	double PROPERTY(period) = 0;
+};
+
+struct Planet
+{
+	BINARY_STRUCT(Planet)
+	string PROPERTY(name);
+	int PROPERTY(diameter) = 0;
+	float PROPERTY(earth_masses) = 0;
+	bool PROPERTY(habitable) = false;
+	Orbit PROPERTY(orbit);
+};
+
+struct Star
+{
+	BINARY_STRUCT(Star)
+
+	StarType PROPERTY(type) = StarType::YellowDwarf;
+	string PROPERTY(name);
+	vector<Planet> PROPERTY(planets);
+	map<string, vector<float>> PROPERTY(spectra);
+};
+
+void BinaryWrite(const filesystem::path& path)
+{
+	Star sun;
+	sun.name = "Sun";
+	sun.type = StarType::YellowDwarf;
+
+	sun.planets = {
+		{"Mercury", 4879, 0.055f, false, {0.387, 0.206, 88.0}},
+		{"Venus", 12104, 0.815f, false, {0.723, 0.007, 224.7}},
+		{"Earth", 12714, 1.0f, true, {1.0, 0.017, 365.2}},
+		{"Mars", 6755, 0.107f, false, {1.524, 0.093, 687.0}},
+		{"Jupiter", 133709, 317.83f, false, {5.203, 0.048, 4331.0}},
+		{"Saturn", 120536, 95.16f, false, {9.537, 0.054, 10747.0}},
+		{"Uranus", 49946, 14.536f, false, {19.19, 0.047, 30589.0}},
+		{"Neptune", 48682, 17.15f, false, {30.07, 0.009, 59800.0}}
+	};
+
+	sun.spectra["visible"] = { 0.38f, 0.45f, 0.5f, 0.57f, 0.59f, 0.62f, 0.75f };
+
+	vector<char> data = BinaryArchive::Save(sun);
+	ofstream file(path, ios::binary);
+	file.write(data.data(), data.size());
+}
+
+Star BinaryRead(const filesystem::path& path)
+{
+	ifstream file(path, ios::binary);
+	vector<char> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+	Star star;
+	BinaryArchive::Load(star, data); // properties added since the archive was written keep their values
+	return star;
+}
+
+int main()
+{
+	filesystem::path path = "SolarSystem.bin";
+	BinaryWrite(path);
+	Star sun = BinaryRead(path);
+
+	cout << sun.name << " (" << Enum<StarType>::ToString(sun.type) << "), " << filesystem::file_size(path) << " bytes\n";
+	for (const Planet& planet : sun.planets)
+		cout << planet.name << ": " << planet.diameter << " km, " << planet.orbit.period << " days\n";
+
+	return 0;
+}
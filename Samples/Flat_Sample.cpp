@@ -0,0 +1,97 @@
+// This is an example of the FlatArchive addon: objects are written in a layout that is read in place from a memory mapped file
+// Opening costs a single mmap call, nothing is parsed or allocated until a value is accessed
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+#include "MirrorExpress.h"
+#include "FlatArchive.hpp"
+
+using namespace std;
+using namespace Mirror;
+
+enum class Material { ENUM(Material, Stone, Metal, Wood, Glass) };
+
+// Trivially copyable types that aren't reflected are stored as is
+struct Vec3
+{
+	float x = 0, y = 0, z = 0;
+};
+
+struct Bounds
+{
+	FLAT_STRUCT(Bounds)
+	Vec3 PROPERTY(min);
+	Vec3 PROPERTY(max);
+};
+
+struct Mesh
+{
+	FLAT_STRUCT(Mesh)
+	string PROPERTY(name);
+	Material PROPERTY(material) = Material::Stone;
+	Bounds PROPERTY(bounds);
+	vector<float> PROPERTY(vertices);
+	vector<uint32_t> PROPERTY(indices);
+};
+
+struct AssetDatabase
+{
+	FLAT_STRUCT(AssetDatabase)
+	uint32_t PROPERTY(version) = 0;
+	vector<string> PROPERTY(tags);
+	vector<Mesh> PROPERTY(meshes);
+};
+
+void FlatWrite(const filesystem::path& path)
+{
+	AssetDatabase database;
+	database.version = 3;
+	database.tags = { "props", "level1" };
+
+	for (int i = 0; i < 4; i++)
+	{
+		Mesh& mesh = database.meshes.emplace_back();
+		mesh.name = "crate_" + to_string(i);
+		mesh.material = Material(i % 4);
+		mesh.bounds = {{0, 0, 0}, {1.0f + i, 1, 1}};
+		mesh.vertices = { 0, 0, 0, 1.0f + i, 0, 0, 0, 1, 0 };
+		mesh.indices = { 0, 1, 2 };
+	}
+
+	vector<char> data = FlatArchive::Save(database);
+	ofstream file(path, ios::binary);
+	file.write(data.data(), data.size());
+}
+
+int main()
+{
+	filesystem::path path = "Assets.flat";
+	FlatWrite(path);
+
+	FlatFile file(path);
+	FlatView database = file.Root<AssetDatabase>(); // throws if the file was written with a different schema
+
+	cout << "version " << database.Get<uint32_t>("version") << ", " << file.Data().size() << " bytes\n";
+
+	FlatArray tags = database.GetArray("tags");
+	for (size_t i = 0; i < tags.Size(); i++)
+		cout << "tag: " << tags.String(i) << "\n";
+
+	// slots can be looked up once and reused for every record of the class
+	FlatArray meshes = database.GetArray("meshes");
+	const FlatLayout& layout = FlatLayout::Get(Mesh::Meta::GetClass());
+	const FlatLayout::Slot& name = layout.GetSlot("name");
+	const FlatLayout::Slot& vertices = layout.GetSlot("vertices");
+
+	for (size_t i = 0; i < meshes.Size(); i++)
+	{
+		FlatView mesh = meshes.Object(i);
+		span<const float> points = mesh.GetArray(vertices).Values<float>();
+		cout << mesh.GetString(name) << " (" << Enum<Material>::ToString(mesh.Get<Material>("material")) << "): "
+			<< points.size() / 3 << " vertices, max x " << mesh.GetObject("bounds").Get<Vec3>("max").x << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+// Measures parallel loading of newline delimited json records against the number of threads
+// Build with optimizations enabled, e.g. -O2 or /O2
+
+#include <iostream>
+#include <chrono>
+#include <format>
+
+#include "Json_Sample.h"
+
+enum class Level { ENUM(Level, Trace, Debug, Info, Warning, Error) };
+
+struct LogRecord
+{
+	JSON_STRUCT(LogRecord)
+	uint64_t PROPERTY(timestamp) = 0;
+	Level PROPERTY(level) = Level::Info;
+	int PROPERTY(thread) = 0;
+	double PROPERTY(duration) = 0;
+	string PROPERTY(source);
+	string PROPERTY(message);
+	vector<int> PROPERTY(tags);
+};
+
+string MakeLines(size_t num)
+{
+	const char* sources[] = { "renderer", "physics", "audio", "network", "scripts" };
+
+	string text;
+	for (size_t i = 0; i < num; i++)
+	{
+		LogRecord record;
+		record.timestamp = 1700000000000 + i * 17;
+		record.level = Level(i % 5);
+		record.thread = int(i % 12);
+		record.duration = double(i % 1000) * 0.125;
+		record.source = sources[i % size(sources)];
+		record.message = format("frame {} finished with {} draw calls", i, i % 3000);
+		record.tags = { int(i % 7), int(i % 11), int(i % 13) };
+
+		JsonWriter writer;
+		JsonReadWrite<LogRecord>::Write(record, writer);
+		text.append(writer.View()).append("\n");
+	}
+	return text;
+}
+
+int main()
+{
+	constexpr size_t num = 1000000;
+	string text = MakeLines(num);
+	cout << format("{} records, {:.1f} MB\n", num, double(text.size()) / (1 << 20));
+
+	double single = 0;
+	for (size_t threads = 1; threads <= max(1u, thread::hardware_concurrency()); threads *= 2)
+	{
+		auto start = chrono::steady_clock::now();
+		vector<LogRecord> records = JsonReadLines<LogRecord>(text, threads);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		if (records.size() != num || records.back().thread != int((num - 1) % 12)) cout << "load failure\n";
+		if (threads == 1) single = seconds;
+
+		cout << format("{:3} threads: {:10.0f} records/s, speedup {:.2f}\n", threads, double(num) / seconds, single / seconds);
+	}
+
+	return 0;
+}
@@ -7,6 +7,9 @@
 #include "Json_Sample.h"
 
 enum class StarType { ENUM(StarType, YellowDwarf, RedDwarf, RedGiant, RedSuperGiant, BlueGiant, WhiteDwarf, BrownDwarf) };
+enum class Features { FLAGS_ENUM(Features, Moons = 1, Rings = 2, Atmosphere = 4) }; // written as "Moons|Rings", no flags as ""
+
+Features operator|(Features a, Features b) { return Features(int(a) | int(b)); }
 
 struct Planet
 {
@@ -15,6 +18,7 @@ struct Planet
 	int PROPERTY(diameter);
 	float PROPERTY(earth_masses);
 	bool PROPERTY(habitable) = false;
+	Features PROPERTY(features) = {};
 };
 
 struct Star
@@ -34,31 +38,30 @@ void JsonWrite(const filesystem::path& path)
 
 	sun.planets = {
 		{"Mercury", 4879, 0.055f},
-		{"Venus", 12104, 0.815f},
-		{"Earth", 12714, 1.0f, true},
-		{"Mars", 6755, 0.107f},
-		{"Jupiter", 133709, 317.83f},
-		{"Saturn", 120536, 95.16f},
-		{"Uranus", 49946, 14.536f},
-		{"Neptune", 48682, 17.15f}
+		{"Venus", 12104, 0.815f, false, Features::Atmosphere},
+		{"Earth", 12714, 1.0f, true, Features::Moons | Features::Atmosphere},
+		{"Mars", 6755, 0.107f, false, Features::Moons | Features::Atmosphere},
+		{"Jupiter", 133709, 317.83f, false, Features::Moons | Features::Rings | Features::Atmosphere},
+		{"Saturn", 120536, 95.16f, false, Features::Moons | Features::Rings | Features::Atmosphere},
+		{"Uranus", 49946, 14.536f, false, Features::Moons | Features::Rings | Features::Atmosphere},
+		{"Neptune", 48682, 17.15f, false, Features::Moons | Features::Rings | Features::Atmosphere}
 	};
 
-	JsonBox::Value jval;
-	JsonReadWrite<Star>::Write(sun, jval);
-
+	// objects are written straight to the file without building a json document
 	fstream file(path, ios::out);
-	jval.writeToStream(file);
+	JsonWriter writer(file);
+	JsonReadWrite<Star>::Write(sun, writer);
 }
 
 Star JsonRead(const filesystem::path& path)
 {
 	fstream file("SolarSystem.json", ios::in);
+	string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
 
-	JsonBox::Value jval;
-	jval.loadFromStream(file);
-
+	// values are parsed straight into the object without building a json document
 	Star star;
-	JsonReadWrite<Star>::Read(star, jval);
+	JsonReader reader(text);
+	JsonReadWrite<Star>::Read(star, reader);
 	return star;
 }
 
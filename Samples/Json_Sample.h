@@ -1,5 +1,19 @@
 #pragma once
 
+#include <ostream>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <bit>
+#include <charconv>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define JSON_SSE2
+#endif
+
 #include "MirrorExpress.h"
 #include "JsonBox.h"
 
@@ -12,16 +26,317 @@ using namespace Mirror; // but it makes it easier because c++ doesn't support ne
 template<typename>
 struct JsonReadWrite; // it's convenient to keep Read and Write implementations in a single templated struct
 
+// Streaming json output without a DOM. Text is formatted into a growable buffer that is flushed to a stream if there is one.
+class JsonWriter
+{
+	vector<char> buffer;
+	size_t size = 0;
+	ostream* stream = nullptr;
+
+	static constexpr size_t flush_size = 64 * 1024;
+
+public:
+	JsonWriter() = default;
+	explicit JsonWriter(ostream& stream) : buffer(flush_size * 2), stream(&stream) {}
+	~JsonWriter() { Flush(); }
+
+	// Space for at least count chars at the end of the output
+	char* Reserve(size_t count)
+	{
+		if (stream && size + count > flush_size) Flush();
+		if (size + count > buffer.size()) buffer.resize(max(buffer.size() * 2, size + count));
+		return buffer.data() + size;
+	}
+
+	void Commit(char* end) { size = end - buffer.data(); }
+
+	void Raw(string_view text) { Commit(copy(text.begin(), text.end(), Reserve(text.size()))); }
+	void Char(char c) { *Reserve(1) = c; size++; }
+
+	template<typename Type> requires is_arithmetic_v<Type>
+	void Number(Type value)
+	{
+		if constexpr (is_floating_point_v<Type>)
+			if (value != value || value - value != 0) return Raw("null"); // json has no nan and infinity
+
+		char* ptr = Reserve(32);
+		Commit(to_chars(ptr, ptr + 32, value).ptr);
+	}
+
+	void Bool(bool value) { Raw(value ? "true" : "false"); }
+
+	// Quoted string, characters that don't need escaping are copied in runs
+	void String(string_view str)
+	{
+		static constexpr auto escapes = []
+		{
+			array<char, 256> table{};
+			for (int c = 0; c < 0x20; c++) table[c] = 'u';
+			table['"'] = '"'; table['\\'] = '\\';
+			table['\b'] = 'b'; table['\f'] = 'f'; table['\n'] = 'n'; table['\r'] = 'r'; table['\t'] = 't';
+			return table;
+		}();
+
+		Char('"');
+		size_t run = 0;
+		for (size_t i = 0; i < str.size(); i++)
+		{
+			char escape = escapes[uint8_t(str[i])];
+			if (!escape) continue;
+
+			Raw(str.substr(run, i - run));
+			run = i + 1;
+
+			char* ptr = Reserve(6);
+			ptr[0] = '\\';
+			ptr[1] = escape;
+			if (escape != 'u') { Commit(ptr + 2); continue; }
+
+			const char* digits = "0123456789abcdef";
+			ptr[2] = '0'; ptr[3] = '0'; ptr[4] = digits[uint8_t(str[i]) >> 4]; ptr[5] = digits[str[i] & 15];
+			Commit(ptr + 6);
+		}
+		Raw(str.substr(run));
+		Char('"');
+	}
+
+	// Output written so far, only the not flushed part if there is a stream
+	string_view View() const { return string_view(buffer.data(), size); }
+
+	void Flush()
+	{
+		if (!stream || !size) return;
+		stream->write(buffer.data(), size);
+		size = 0;
+	}
+};
+
+// Json text parser that reads values straight into objects without a DOM.
+// Structural characters, quotes and whitespace are scanned 16 bytes at a time with SSE2.
+class JsonReader
+{
+	const char* begin;
+	const char* pos;
+	const char* end;
+	string scratch; // unescaped keys, reused
+
+public:
+	explicit JsonReader(string_view text) : begin(text.data()), pos(text.data()), end(text.data() + text.size()) {}
+
+	// First of Chars or end
+	template<char... Chars>
+	static const char* Find(const char* ptr, const char* end)
+	{
+#ifdef JSON_SSE2
+		for (; end - ptr >= 16; ptr += 16)
+		{
+			__m128i chunk = _mm_loadu_si128((const __m128i*)ptr);
+			__m128i hits = _mm_setzero_si128();
+			((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(Chars)))), ...);
+			if (int mask = _mm_movemask_epi8(hits)) return ptr + countr_zero(unsigned(mask));
+		}
+#endif
+		while (ptr < end && ((*ptr != Chars) && ...)) ptr++;
+		return ptr;
+	}
+
+	void SkipSpace()
+	{
+#ifdef JSON_SSE2
+		while (end - pos >= 16 && IsSpace(*pos))
+		{
+			__m128i chunk = _mm_loadu_si128((const __m128i*)pos);
+			__m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+			unsigned mask = ~unsigned(_mm_movemask_epi8(space)) & 0xffff;
+			pos += mask ? countr_zero(mask) : 16;
+		}
+#endif
+		while (pos < end && IsSpace(*pos)) pos++;
+	}
+
+	char Peek()
+	{
+		SkipSpace();
+		return pos < end ? *pos : '\0';
+	}
+
+	bool Consume(char c)
+	{
+		if (Peek() != c) return false;
+		pos++;
+		return true;
+	}
+
+	void Expect(char c)
+	{
+		if (!Consume(c))
+			Fail(format("expected '{}'", c));
+	}
+
+	bool Literal(string_view word)
+	{
+		if (Peek() != word[0] || size_t(end - pos) < word.size() || string_view(pos, word.size()) != word) return false;
+		pos += word.size();
+		return true;
+	}
+
+	bool Null() { return Literal("null"); }
+
+	bool Bool()
+	{
+		if (Literal("true")) return true;
+		if (Literal("false")) return false;
+		Fail("expected a boolean");
+	}
+
+	template<typename Type> requires is_arithmetic_v<Type>
+	void Number(Type& value)
+	{
+		SkipSpace();
+		auto [ptr, error] = from_chars(pos, end, value);
+		if (error != errc())
+			Fail("expected a number");
+		pos = ptr;
+	}
+
+	// Object key followed by a colon. Keys without escapes are views into the input.
+	string_view Key()
+	{
+		string_view key = Text(scratch);
+		Expect(':');
+		return key;
+	}
+
+	// Quoted string valid until the next read
+	string_view String() { return Text(scratch); }
+
+	void String(string& str)
+	{
+		string_view text = Text(str);
+		if (text.data() != str.data()) str.assign(text);
+	}
+
+	// Skip a value of any type
+	void Skip()
+	{
+		char c = Peek();
+		if (c == '"') { Text(scratch); return; }
+		if (c != '{' && c != '[')
+		{
+			pos = Find<',', '}', ']'>(pos, end);
+			return;
+		}
+
+		int depth = 0;
+		do
+		{
+			pos = Find<'"', '{', '}', '[', ']'>(pos, end);
+			if (pos == end) Fail("unexpected end");
+
+			switch (*pos)
+			{
+			case '"': Text(scratch); continue;
+			case '{': case '[': depth++; break;
+			default: depth--;
+			}
+			pos++;
+		}
+		while (depth > 0);
+	}
+
+	[[noreturn]] void Fail(string_view message) const
+	{
+		throw logic_error(format("Json parse error at {}: {}", pos - begin, message));
+	}
+
+private:
+	static bool IsSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+	// Quoted string as a view into the input, or unescaped into storage if it has escapes
+	string_view Text(string& storage)
+	{
+		Expect('"');
+		const char* start = pos;
+		pos = Find<'"', '\\'>(pos, end);
+		if (pos == end) Fail("unterminated string");
+		if (*pos == '"') return string_view(start, pos++ - start);
+
+		storage.assign(start, pos);
+		while (*pos != '"')
+		{
+			if (*pos == '\\') Unescape(storage);
+			const char* run = pos;
+			pos = Find<'"', '\\'>(pos, end);
+			if (pos == end) Fail("unterminated string");
+			storage.append(run, pos);
+		}
+		pos++;
+		return storage;
+	}
+
+	void Unescape(string& storage)
+	{
+		if (end - pos < 2) Fail("unterminated string");
+		char c = pos[1];
+		pos += 2;
+		switch (c)
+		{
+		case 'b': storage += '\b'; return;
+		case 'f': storage += '\f'; return;
+		case 'n': storage += '\n'; return;
+		case 'r': storage += '\r'; return;
+		case 't': storage += '\t'; return;
+		case 'u': break;
+		default: storage += c; return;
+		}
+
+		uint32_t code = Hex();
+		if (code >= 0xd800 && code < 0xdc00 && end - pos >= 2 && pos[0] == '\\' && pos[1] == 'u')
+		{
+			pos += 2;
+			code = 0x10000 + ((code - 0xd800) << 10) + (Hex() - 0xdc00);
+		}
+
+		// utf-8
+		if (code < 0x80) storage += char(code);
+		else if (code < 0x800) storage += { char(0xc0 | code >> 6), char(0x80 | (code & 0x3f)) };
+		else if (code < 0x10000) storage += { char(0xe0 | code >> 12), char(0x80 | (code >> 6 & 0x3f)), char(0x80 | (code & 0x3f)) };
+		else storage += { char(0xf0 | code >> 18), char(0x80 | (code >> 12 & 0x3f)), char(0x80 | (code >> 6 & 0x3f)), char(0x80 | (code & 0x3f)) };
+	}
+
+	uint32_t Hex()
+	{
+		uint32_t code = 0;
+		if (end - pos < 4 || from_chars(pos, pos + 4, code, 16).ptr != pos + 4) Fail("invalid unicode escape");
+		pos += 4;
+		return code;
+	}
+};
+
 struct JsonMetaData : virtual Property // virtual inheritance to make it possible to combine different metas into a single property class
 {
 	void (*write)(void*, const Property*, JsonBox::Value&);
 	void (*read)(void*, const Property*, const JsonBox::Value&);
+	void (*stream)(void*, const Property*, JsonWriter&);
+	void (*parse)(void*, const Property*, JsonReader&);
+	void (*reset)(void*, const Property*, void*) = nullptr; // copy the value of a default object, null if it can't be copied
+	string key; // escaped and quoted name with a trailing colon, formatted once per class
 
 	template<typename PropertyMeta>
 	JsonMetaData(PropertyMeta* meta) : Property(meta)
 	{
 		write = &JsonMetaData::Write<typename PropertyMeta::Type>;
 		read = &JsonMetaData::Read<typename PropertyMeta::Type>;
+		stream = &JsonMetaData::Stream<typename PropertyMeta::Type>;
+		parse = &JsonMetaData::Parse<typename PropertyMeta::Type>;
+		if constexpr (is_copy_constructible_v<typename PropertyMeta::Type>)
+			reset = &JsonMetaData::Reset<typename PropertyMeta::Type>;
+
+		JsonWriter writer;
+		writer.String(name);
+		writer.Char(':');
+		key = writer.View();
 	}
 
 	template<typename PropertyType>
@@ -30,13 +345,47 @@ struct JsonMetaData : virtual Property // virtual inheritance to make it possibl
 		JsonReadWrite<PropertyType>::Write(property->GetValue<PropertyType>(obj), jval);
 	}
 
+	template<typename PropertyType>
+	static void Stream(void* obj, const Property* property, JsonWriter& writer)
+	{
+		JsonReadWrite<PropertyType>::Write(property->GetValue<PropertyType>(obj), writer);
+	}
+
+	// Data members without a custom setter are parsed in place
+	template<typename PropertyType>
+	static void Parse(void* obj, const Property* property, JsonReader& reader)
+	{
+		if (void* storage = property->GetStorage(obj))
+		{
+			JsonReadWrite<PropertyType>::Read(*(PropertyType*)storage, reader);
+			return;
+		}
+
+		PropertyType value;
+		JsonReadWrite<PropertyType>::Read(value, reader);
+		property->SetValue(obj, move(value));
+	}
+
 	template<typename PropertyType>
 	static void Read(void* obj, const Property* property, const JsonBox::Value& jval)
 	{
+		if (void* storage = property->GetStorage(obj))
+		{
+			JsonReadWrite<PropertyType>::Read(*(PropertyType*)storage, jval);
+			return;
+		}
+
 		PropertyType value;
 		JsonReadWrite<PropertyType>::Read(value, jval);
 		property->SetValue(obj, move(value));		
 	}
+
+	template<typename PropertyType>
+	static void Reset(void* obj, const Property* property, void* defaults)
+	{
+		PropertyType value = property->GetValue<PropertyType>(defaults);
+		property->SetValue(obj, move(value));
+	}
 };
 
 template<Mirrored Type>
@@ -56,6 +405,62 @@ struct JsonReadWrite<Type>
 		jval.setObject(jobj);
 	}
 
+	static void Write(const Type& obj, JsonWriter& writer)
+	{
+		string_view separator = "{";
+		for (const JsonMetaData* property : Type::Meta::Properties())
+		{
+			writer.Raw(separator);
+			writer.Raw(property->key);
+			property->stream(obj.GetThis(), property, writer);
+			separator = ",";
+		}
+		writer.Raw(separator == "{" ? "{}" : "}");
+	}
+
+	static void Read(Type& obj, JsonReader& reader)
+	{
+		static const NameTable<JsonMetaData> keys = []
+		{
+			NameTable<JsonMetaData> table;
+			table.Build(Type::Meta::Properties());
+			return table;
+		}();
+
+		if (reader.Null()) return;
+
+		// properties are read in place and keep their capacity, the ones missing in the json are reset afterwards
+		size_t num = Type::Meta::PropertiesNum();
+		uint64_t inline_seen[4] = {};
+		vector<uint64_t> heap_seen(num > 256 ? (num + 63) / 64 : 0);
+		uint64_t* seen = num > 256 ? heap_seen.data() : inline_seen;
+		size_t seen_num = 0;
+
+		reader.Expect('{');
+		if (!reader.Consume('}'))
+		{
+			do
+			{
+				if (const JsonMetaData* property = keys.Find(reader.Key()))
+				{
+					property->parse(obj.GetThis(), property, reader);
+					uint64_t bit = 1ull << (property->index % 64);
+					seen_num += !(seen[property->index / 64] & bit);
+					seen[property->index / 64] |= bit;
+				}
+				else
+					reader.Skip();
+			}
+			while (reader.Consume(','));
+			reader.Expect('}');
+		}
+
+		if (seen_num < num)
+			for (const JsonMetaData* property : Type::Meta::Properties())
+				if (!(seen[property->index / 64] >> (property->index % 64) & 1))
+					ResetProperty(obj, property);
+	}
+
 	static void Read(Type& obj, const JsonBox::Value& jval)
 	{
 		if (jval.isNull()) return;
@@ -70,6 +475,18 @@ struct JsonReadWrite<Type>
 			auto it = jobj.find(string(property->name));
 			if (it != jobj.end())
 				property->read(obj.GetThis(), property, it->second);
+			else
+				ResetProperty(obj, property);
+		}
+	}
+
+	// Values missing in the json are set to the ones of a default object, so reused objects don't keep stale values
+	static void ResetProperty(Type& obj, const JsonMetaData* property)
+	{
+		if constexpr (default_initializable<Type>)
+		{
+			static Type defaults;
+			if (property->reset) property->reset(obj.GetThis(), property, defaults.GetThis());
 		}
 	}
 };
@@ -82,6 +499,22 @@ struct JsonReadWrite<Type>
 		jval.setInt(int(value));
 	}
 
+	static void Write(const Type& value, JsonWriter& writer) { writer.Number(value); }
+
+	static void Read(Type& value, JsonReader& reader)
+	{
+		if (reader.Null())
+			value = Type(0);
+		else if (reader.Peek() == '"')
+		{
+			string_view text = reader.String();
+			if (from_chars(text.data(), text.data() + text.size(), value).ec != errc())
+				reader.Fail("expected an integer string");
+		}
+		else
+			reader.Number(value);
+	}
+
 	static void Read(Type& value, const JsonBox::Value& jval)
 	{
 		if (!jval.isNull())
@@ -99,18 +532,40 @@ struct JsonReadWrite<Type>
 };
 
 template<typename Type> requires is_enum_v<Type>
-struct JsonReadWrite<Type>
+struct JsonReadWrite<Type> // flags enums are written as "A|B|C"
 {
 	static void Write(const Type& value, JsonBox::Value& jval)
 	{
-		jval.setString((string)Enum<Type>::ToString(value));
+		if (Flags<Type>::IsFlags())
+			jval.setString(Flags<Type>::ToString(value));
+		else
+			jval.setString((string)Enum<Type>::ToString(value));
+	}
+
+	static void Write(const Type& value, JsonWriter& writer)
+	{
+		if (Flags<Type>::IsFlags())
+		{
+			char buffer[256];
+			string fallback;
+			writer.String(Flags<Type>::ToString(value, buffer, fallback));
+		}
+		else
+			writer.String(Enum<Type>::ToString(value));
+	}
+
+	static void Read(Type& value, JsonReader& reader)
+	{
+		if (reader.Peek() != '"')
+			reader.Fail("expected an enum string");
+		value = Flags<Type>::IsFlags() ? Flags<Type>::ToValue(reader.String()) : Enum<Type>::ToValue(reader.String());
 	}
 
 	static void Read(Type& value, const JsonBox::Value& jval)
 	{
 		if (!jval.isString())
 			throw logic_error("JsonValue for enum is not a string");
-		value = Enum<Type>::ToValue(jval.getString());
+		value = Flags<Type>::IsFlags() ? Flags<Type>::ToValue(jval.getString()) : Enum<Type>::ToValue(jval.getString());
 	}
 };
 
@@ -122,6 +577,10 @@ struct JsonReadWrite<Type>
 		jval.setDouble(double(fvalue));
 	}
 
+	static void Write(const Type& fvalue, JsonWriter& writer) { writer.Number(fvalue); }
+
+	static void Read(Type& fvalue, JsonReader& reader) { reader.Number(fvalue); }
+
 	static void Read(Type& fvalue, const JsonBox::Value& jval)
 	{
 		if (!jval.isDouble() && !jval.isInteger())
@@ -138,6 +597,10 @@ struct JsonReadWrite<bool>
 		jval.setBoolean(value);
 	}
 
+	static void Write(const bool& value, JsonWriter& writer) { writer.Bool(value); }
+
+	static void Read(bool& value, JsonReader& reader) { value = reader.Bool(); }
+
 	static void Read(bool& value, const JsonBox::Value& jval)
 	{
 		if (!jval.isBoolean())
@@ -154,6 +617,15 @@ struct JsonReadWrite<string>
 		jval.setString(str);
 	}
 
+	static void Write(const string& str, JsonWriter& writer) { writer.String(str); }
+
+	static void Read(string& str, JsonReader& reader)
+	{
+		if (reader.Peek() != '"')
+			reader.Fail("expected a string");
+		reader.String(str);
+	}
+
 	static void Read(string& str, const JsonBox::Value& jval)
 	{
 		if (!jval.isString())
@@ -176,15 +648,172 @@ struct JsonReadWrite<Type>
 		jval.setArray(jary);
 	}
 
+	static void Write(const Type& range, JsonWriter& writer)
+	{
+		writer.Char('[');
+		for (auto it = begin(range); it != end(range); ++it)
+		{
+			if (it != begin(range)) writer.Char(',');
+			JsonReadWrite<ValueType>::Write(*it, writer);
+		}
+		writer.Char(']');
+	}
+
+	// Resizable sequences reuse their elements, other ranges are rebuilt
+	static void Read(Type& range, JsonReader& reader)
+	{
+		reader.Expect('[');
+		if constexpr (requires { range.emplace_back(); range.resize(size_t(0)); })
+		{
+			size_t count = 0;
+			auto it = begin(range);
+			if (!reader.Consume(']'))
+			{
+				do
+				{
+					if (it == end(range))
+					{
+						range.emplace_back();
+						it = prev(end(range));
+					}
+					JsonReadWrite<ValueType>::Read(*it++, reader);
+					count++;
+				}
+				while (reader.Consume(','));
+				reader.Expect(']');
+			}
+			range.resize(count);
+		}
+		else
+		{
+			vector<ValueType> values;
+			if (!reader.Consume(']'))
+			{
+				do JsonReadWrite<ValueType>::Read(values.emplace_back(), reader);
+				while (reader.Consume(','));
+				reader.Expect(']');
+			}
+			range = Type(make_move_iterator(values.begin()), make_move_iterator(values.end()));
+		}
+	}
+
 	static void Read(Type& range, const JsonBox::Value& jval)
 	{
 		if (!jval.isArray())
 			throw logic_error("JsonValue is not an array.");
 
 		const JsonBox::Array& jary = jval.getArray();
+		if constexpr (requires { range.resize(jary.size()); })
+		{
+			range.resize(jary.size());
+			unsigned i = 0;
+			for (auto& value : range)
+				JsonReadWrite<ValueType>::Read(value, jary[i++]);
+			return;
+		}
+
 		vector<ValueType> values(jary.size());
 		for (unsigned i = 0; i < jary.size(); i++)
 			JsonReadWrite<ValueType>::Read(values[i], jary[i]);
 		range = Type(make_move_iterator(values.begin()), make_move_iterator(values.end()));
 	}
 };
+
+
+// Parse newline delimited json records on several threads.
+// Input is split into chunks at line ends and workers claim chunks from a shared counter, so fast threads take over the remaining work.
+// Records are counted first, then every chunk parses straight into its place in the result.
+template<typename Type>
+vector<Type> JsonReadLines(string_view text, size_t threads = thread::hardware_concurrency())
+{
+	struct Chunk
+	{
+		string_view text;
+		size_t first = 0; // index of the first record
+		size_t count = 0;
+	};
+
+	auto for_each_line = [](string_view text, auto&& func)
+	{
+		for (const char* pos = text.data(), *end = pos + text.size(); pos < end;)
+		{
+			const char* line_end = JsonReader::Find<'\n'>(pos, end);
+			string_view line(pos, line_end - pos);
+			if (line.find_first_not_of(" \t\r") != string_view::npos) func(line);
+			pos = line_end + 1;
+		}
+	};
+
+	threads = max<size_t>(threads, 1);
+	size_t target = max<size_t>(text.size() / (threads * 16), 64 * 1024);
+
+	vector<Chunk> chunks;
+	for (size_t pos = 0; pos < text.size();)
+	{
+		size_t end = pos + target < text.size() ? text.find('\n', pos + target) : string_view::npos;
+		end = end == string_view::npos ? text.size() : end + 1;
+		chunks.push_back({text.substr(pos, end - pos)});
+		pos = end;
+	}
+
+	auto parallel = [&](auto&& work)
+	{
+		atomic<size_t> next = 0;
+		exception_ptr error;
+		mutex guard;
+
+		auto worker = [&]
+		{
+			for (size_t i; (i = next++) < chunks.size();)
+			{
+				try { work(chunks[i]); }
+				catch (...)
+				{
+					lock_guard lock(guard);
+					if (!error) error = current_exception();
+					next = chunks.size();
+				}
+			}
+		};
+
+		vector<jthread> pool;
+		for (size_t i = 1; i < min(threads, chunks.size()); i++)
+			pool.emplace_back(worker);
+		worker();
+		pool.clear();
+
+		if (error) rethrow_exception(error);
+	};
+
+	parallel([&](Chunk& chunk){ for_each_line(chunk.text, [&](string_view){ chunk.count++; }); });
+
+	size_t total = 0;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.first = total;
+		total += chunk.count;
+	}
+
+	vector<Type> records(total);
+	parallel([&](Chunk& chunk)
+	{
+		size_t index = chunk.first;
+		for_each_line(chunk.text, [&](string_view line)
+		{
+			try
+			{
+				JsonReader reader(line);
+				JsonReadWrite<Type>::Read(records[index], reader);
+				if (reader.Peek() != '\0')
+					reader.Fail("unexpected data after the record");
+			}
+			catch (const logic_error& e)
+			{
+				throw logic_error(format("Json record {}: {}", index + 1, e.what()));
+			}
+			index++;
+		});
+	});
+
+	return records;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+// Compares the perfect hash name table used by Mirror::Class against the unordered_multimap it replaced
+// Build with optimizations enabled, e.g. -O2 or /O2
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <format>
+
+#include "MirrorTable.h"
+
+using namespace std;
+using namespace Mirror;
+
+struct Named
+{
+	string_view name;
+};
+
+vector<string> MakeNames(size_t num)
+{
+	const char* words[] = { "position", "velocity", "health", "armor", "color", "scale", "target", "speed",
+		"name", "owner", "flags", "state", "timer", "range", "damage", "level" };
+
+	vector<string> names;
+	for (size_t i = 0; names.size() < num; i++)
+	{
+		string name = words[i % size(words)];
+		if (i >= size(words)) name.append("_").append(words[i / size(words) % size(words)]);
+		if (i >= size(words) * size(words)) name.append("_").append(to_string(i));
+		names.push_back(move(name));
+	}
+	return names;
+}
+
+template<typename Lookup>
+double Measure(const vector<string>& keys, Lookup&& lookup)
+{
+	constexpr int rounds = 200;
+	size_t found = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (int round = 0; round < rounds; round++)
+		for (const string& key : keys)
+			found += lookup(string_view(key)) != nullptr;
+	auto duration = chrono::duration<double, nano>(chrono::steady_clock::now() - start);
+
+	if (found != keys.size() * rounds) cout << "lookup failure\n";
+	return duration.count() / double(keys.size() * rounds);
+}
+
+void Benchmark(size_t num)
+{
+	vector<string> names = MakeNames(num);
+	vector<Named> items(num);
+	vector<const Named*> pointers;
+	for (size_t i = 0; i < num; i++)
+	{
+		items[i].name = names[i];
+		pointers.push_back(&items[i]);
+	}
+
+	unordered_multimap<string_view, const Named*> map;
+	for (const Named* item : pointers) map.emplace(item->name, item);
+
+	NameTable<Named> table;
+	table.Build(pointers);
+
+	// keys are separate copies so that neither structure can compare pointers
+	vector<string> keys = names;
+	for (size_t i = 0; i < keys.size(); i++) swap(keys[i], keys[(i * 7919) % keys.size()]);
+
+	double map_time = Measure(keys, [&](string_view key) -> const Named*
+	{
+		auto it = map.find(key);
+		return it != map.end() ? it->second : nullptr;
+	});
+
+	double table_time = Measure(keys, [&](string_view key){ return table.Find(key); });
+
+	cout << format("{:4} properties: unordered_multimap {:6.2f} ns, NameTable {:6.2f} ns\n", num, map_time, table_time);
+}
+
+int main()
+{
+	for (size_t num : { 8, 64, 512 })
+		Benchmark(num);
+
+	return 0;
+}
@@ -14,6 +14,8 @@ enum class Color { ENUM(Color, Black, White, Ginger) }; // built-in enum mirror
 enum class Expression { Insolent, Shameless, Begging, Fearsome };
 XENUM(Expression, Insolent, Shameless, Begging, Fearsome); // external enum mirror
 
+enum class Mood { FLAGS_ENUM(Mood, Sleepy = 1, Hungry = 2, Playful = 4) }; // bit flags, also set from "Hungry|Playful" strings
+
 class Animal : public IMirror
 {
 	LUA_CLASS(Animal)
@@ -69,10 +71,26 @@ public:
 		Color PROPERTY(color);
 	};
 
+	struct Whiskers // not an IMirror, copied into a table unless pushed as a proxy
+	{
+		LUA_STRUCT(Whiskers)
+		int PROPERTY(length) = 5;
+	};
+
+	struct Position
+	{
+		LUA_STRUCT(Position)
+		float PROPERTY(x) = 0;
+		float PROPERTY(y) = 0;
+	};
+
 public:
 	Snout PROPERTY(snout);
 	Color PROPERTY(color);
 	Tail PROPERTY(tail);
+	Whiskers PROPERTY(whiskers, METATXT("LuaProxy"));
+	Position PROPERTY(pos, METATXT("LuaProxy"));
+	Mood PROPERTY(mood) = {};
 
 public:
 	Cat() { lifes = 9; }
@@ -108,7 +126,7 @@ int main()
 	LuaBindGetter(lua, LuaGetter);
 	LuaBindEqual(lua, LuaEqual);
 	LuaBindDestructor(lua, LuaDestructor);
-	AddEnum<Color, Expression>(lua);
+	AddEnum<Color, Expression, Mood>(lua);
 
 	luaL_requiref(lua, "_G", luaopen_base, 1);
 	lua_settop(lua, 0);
@@ -3,8 +3,20 @@ cat = GetCat() -- lua possess the cat object and will destroy it on lua_close
 cat.name = "Alice"
 cat.color = Color.Black -- Color is a table and Black is a number in the table. Created with AddEnum.
 cat.snout.expression = Expression.Begging
+cat.whiskers.length = 7 -- whiskers is a proxy of the native struct, so the cat itself is changed
 
 print(cat.name .. " says " .. cat:Meow(3)) -- invokes a native function
+print(cat.name .. " has whiskers of length " .. cat.whiskers.length)
+
+kitten = GetCat()
+kitten.pos.x = 3
+kitten.pos.y = 4
+cat.pos = kitten.pos -- assigning a proxy copies the struct it refers to
+kitten.pos.x = 0
+print(cat.name .. " sits at " .. cat.pos.x .. ", " .. cat.pos.y)
+
+cat.mood = "Hungry|Playful" -- flags are set from names, or from numbers like Mood.Hungry | Mood.Playful
+print(cat.name .. " is " .. Mood.ToString(cat.mood))
 
 print("Good girl!")
 cat.good_pet = true -- the virtual setter of the property will be used
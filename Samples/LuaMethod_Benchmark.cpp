@@ -0,0 +1,102 @@
+// Measures allocations made by Lua while calling a reflected method in a loop,
+// with a closure created on every method access and with the closures cached in the class metatable
+// Build with optimizations enabled, e.g. -O2 or /O2
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+
+#include "MirrorExpress.h"
+#include "LuaBind.hpp"
+
+using namespace std;
+using namespace Mirror;
+
+class Counter : public IMirror
+{
+	LUA_CLASS(Counter)
+
+public:
+	int64_t PROPERTY(total) = 0;
+
+	void METHOD(Add)(int value) { total += value; }
+};
+
+struct Allocations
+{
+	size_t count = 0;
+	size_t bytes = 0;
+};
+
+void* CountingAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	if (nsize == 0)
+	{
+		free(ptr);
+		return nullptr;
+	}
+
+	Allocations* allocations = (Allocations*)ud;
+	if (!ptr || nsize > osize)
+	{
+		allocations->count++;
+		allocations->bytes += nsize;
+	}
+	return realloc(ptr, nsize);
+}
+
+// Method access as it was before closures were cached: every obj:Method() allocates a new closure
+int FreshClosureGetter(lua_State* lua)
+{
+	Mirror::IMirror* obj = *(Mirror::IMirror**)lua_touserdata(lua, 1);
+	const LuaMethod* method = obj->GetClass()->GetMethod<LuaMethod>(lua_tostring(lua, 2));
+	if (!method) return LuaGetter(lua);
+
+	lua_pushlightuserdata(lua, (void*)method);
+	lua_pushcclosure(lua, method->invoke, 1);
+	return 1;
+}
+
+void Benchmark(const char* title, lua_CFunction getter, int calls)
+{
+	Allocations allocations;
+	lua_State* lua = lua_newstate(CountingAlloc, &allocations);
+
+	LuaBindSetter(lua, LuaSetter);
+	LuaBindGetter(lua, getter);
+	LuaBindEqual(lua, LuaEqual);
+	LuaBindDestructor(lua, LuaDestructor);
+
+	Counter counter;
+	if (luaL_loadstring(lua, "local counter, calls = ... for i = 1, calls do counter:Add(1) end") != 0)
+	{
+		cout << "'luaL_loadstring' failed\n";
+		return lua_close(lua);
+	}
+	LuaPush(lua, &counter);
+	lua_pushinteger(lua, calls);
+
+	Allocations setup = allocations;
+	auto start = chrono::steady_clock::now();
+	lua_call(lua, 2, 0);
+	auto duration = chrono::duration<double>(chrono::steady_clock::now() - start);
+
+	size_t count = allocations.count - setup.count;
+	size_t bytes = allocations.bytes - setup.bytes;
+	if (counter.total != calls) cout << "call failure\n";
+
+	cout << format("{:>16}: {:9} allocations, {:7.1f} MB, {:6.1f} ns per call\n", title, count, bytes / 1e6, duration.count() * 1e9 / calls);
+
+	lua_close(lua);
+}
+
+int main()
+{
+	constexpr int calls = 10'000'000;
+
+	Benchmark("fresh closures", FreshClosureGetter, calls);
+	Benchmark("cached closures", LuaGetter, calls);
+
+	return 0;
+}